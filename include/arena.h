@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump allocator for the nodes of one Program. Nodes are carved out of
+// large blocks in parse order, so a tree walk touches memory roughly
+// sequentially, and all of it is returned at once when the arena dies.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align) {
+        size_t start = (used + align - 1) & ~(align - 1);
+        if (blocks.empty() || start + size > capacity) {
+            grow(size + align);
+            start = (used + align - 1) & ~(align - 1);
+        }
+        used = start + size;
+        return blocks.back().get() + start;
+    }
+
+    // The object's destructor is run by its owner (see NodeDelete); only
+    // the memory belongs to the arena.
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t used = 0;
+    size_t capacity = 0;
+
+    void grow(size_t minimum) {
+        capacity = minimum > BLOCK_SIZE ? minimum : BLOCK_SIZE;
+        blocks.emplace_back(new char[capacity]);
+        used = 0;
+    }
+};
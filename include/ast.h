@@ -1,64 +1,112 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <iostream>
+#include "token.h"
+#include "arena.h"
+#include "atom.h"
+#include "env.h"
+
+// Nodes live in their Program's Arena. A Node owns the object (its
+// destructor frees the vectors and strings inside) but not the memory.
+struct NodeDelete {
+    template <typename T> void operator()(T* node) const { node->~T(); }
+};
+template <typename T> using Node = std::unique_ptr<T, NodeDelete>;
+
+// Node-kind tags let the runtime dispatch with a single switch instead of
+// probing every node type with dynamic_cast.
+enum class ExprKind {
+    Number, Float, String, Char, Bool, Variable, Call, MethodCall,
+    This, Get, Set, Array, Dict, Index, Binary, Negate, New
+};
+
+enum class StmtKind {
+    Clear, Set, SetIndex, While, If, For, Func, Class, Call, Update,
+    Property, App, Window, Connect, Return, Import, Try, Expr, Break,
+    Continue, Extern
+};
 
 struct Expr {
+    const ExprKind kind;
+    explicit Expr(ExprKind k) : kind(k) {}
     virtual ~Expr() = default;
     virtual void print() const = 0;
 };
 
 struct NumberExpr : public Expr {
     int value;
-    NumberExpr(int v) : value(v) {}
+    NumberExpr(int v) : Expr(ExprKind::Number), value(v) {}
     void print() const override { std::cout << value; }
 };
 
 struct FloatExpr : public Expr {
     double value;
-    FloatExpr(double v) : value(v) {}
+    FloatExpr(double v) : Expr(ExprKind::Float), value(v) {}
     void print() const override { std::cout << value; }
 };
 
 struct StringExpr : public Expr {
-    std::string value;
-    StringExpr(std::string v) : value(v) {}
+    LinkString value; // Shared with every Value the literal evaluates to
+    StringExpr(std::string v) : Expr(ExprKind::String), value(std::move(v)) {}
     void print() const override { std::cout << "\"" << value << "\""; }
 };
 
 struct CharExpr : public Expr {
     char value;
-    CharExpr(char v) : value(v) {}
+    CharExpr(char v) : Expr(ExprKind::Char), value(v) {}
     void print() const override { std::cout << "'" << value << "'"; }
 };
 
 struct BoolExpr : public Expr {
     bool value;
-    BoolExpr(bool v) : value(v) {}
+    BoolExpr(bool v) : Expr(ExprKind::Bool), value(v) {}
     void print() const override { std::cout << (value ? "true" : "false"); }
 };
 
 struct VariableExpr : public Expr {
-    std::string name;
-    VariableExpr(std::string n) : name(n) {}
+    Atom name;
+    int depth = -1, slot = -1; // Lexical address filled in by Resolver
+    VariableExpr(std::string n) : Expr(ExprKind::Variable), name(n) {}
     void print() const override { std::cout << name; }
 };
 
+// Link-time binding of a call by name. The Resolver fills in the lexical
+// address of a user function; the runtime caches the native lookup the
+// first time the call runs.
+struct CallSite {
+    enum class Link : uint8_t { Unlinked, Native, User };
+    Link link = Link::Unlinked;
+    NativeFn native = nullptr;
+    int depth = -1, slot = -1;
+};
+
 struct CallExpr : public Expr {
-    std::string func;
-    std::vector<std::unique_ptr<Expr>> args;
-    CallExpr(const std::string& f, std::vector<std::unique_ptr<Expr>> a) : func(f), args(std::move(a)) {}
+    Atom func;
+    std::vector<Node<Expr>> args;
+    CallSite site;
+    CallExpr(const std::string& f, std::vector<Node<Expr>> a) : Expr(ExprKind::Call), func(f), args(std::move(a)) {}
     void print() const override { std::cout << func << "(...)"; }
 };
 
+// Monomorphic inline cache for a method lookup: the class seen last time
+// and the method it resolved to. Holding the class keeps its address from
+// being reused by a different class while it is cached.
+struct MethodCache {
+    std::shared_ptr<LinkClass> klass;
+    FuncDecl* method = nullptr;
+};
+
 struct MethodCallExpr : public Expr {
-    std::unique_ptr<Expr> object; 
-    std::string method;           
-    std::vector<std::unique_ptr<Expr>> args; 
+    Node<Expr> object; 
+    Atom method;           
+    std::vector<Node<Expr>> args; 
+    MethodCache cache;
     
-    MethodCallExpr(std::unique_ptr<Expr> o, std::string m, std::vector<std::unique_ptr<Expr>> a)
-    : object(std::move(o)), method(m), args(std::move(a)) {}
+    MethodCallExpr(Node<Expr> o, std::string m, std::vector<Node<Expr>> a)
+    : Expr(ExprKind::MethodCall), object(std::move(o)), method(m), args(std::move(a)) {}
     
     void print() const override {
         object->print(); std::cout << "." << method << "(...)";
@@ -66,28 +114,39 @@ struct MethodCallExpr : public Expr {
 };
 
 struct ThisExpr : public Expr {
-    Token keyword;
-    ThisExpr(Token k) : keyword(k) {}
+    int line; // Not the Token: its text views a source buffer the Program outlives
+    int depth = -1, slot = -1;
+    ThisExpr(int l) : Expr(ExprKind::This), line(l) {}
     void print() const override { std::cout << "this"; }
 }; 
+// Field inline cache: the shape seen last time and the field's slot in it.
+// For a store that added the field, next is the shape it transitioned to.
+struct FieldCache {
+    std::shared_ptr<Shape> shape;
+    std::shared_ptr<Shape> next;
+    int slot = -1;
+};
+
 struct GetExpr : public Expr {
-    std::unique_ptr<Expr> object;
-    std::string name;
+    Node<Expr> object;
+    Atom name;
+    FieldCache cache;
     
-    GetExpr(std::unique_ptr<Expr> obj, std::string n) 
-    : object(std::move(obj)), name(n) {}
+    GetExpr(Node<Expr> obj, std::string n) 
+    : Expr(ExprKind::Get), object(std::move(obj)), name(n) {}
     
     void print() const override { 
         object->print(); std::cout << "." << name; 
     }
 }; 
 struct SetExpr : public Expr {
-    std::unique_ptr<Expr> object;
-    std::string name;
-    std::unique_ptr<Expr> value;
+    Node<Expr> object;
+    Atom name;
+    Node<Expr> value;
+    FieldCache cache;
     
-    SetExpr(std::unique_ptr<Expr> obj, std::string n, std::unique_ptr<Expr> v)
-    : object(std::move(obj)), name(n), value(std::move(v)) {}
+    SetExpr(Node<Expr> obj, std::string n, Node<Expr> v)
+    : Expr(ExprKind::Set), object(std::move(obj)), name(n), value(std::move(v)) {}
     
     void print() const override {
         object->print(); std::cout << "." << name << " = "; value->print();
@@ -95,23 +154,23 @@ struct SetExpr : public Expr {
 };
 
 struct ArrayExpr : public Expr {
-    std::vector<std::unique_ptr<Expr>> elements;
-    ArrayExpr(std::vector<std::unique_ptr<Expr>> el) : elements(std::move(el)) {}
+    std::vector<Node<Expr>> elements;
+    ArrayExpr(std::vector<Node<Expr>> el) : Expr(ExprKind::Array), elements(std::move(el)) {}
     void print() const override { std::cout << "[...]"; }
 };
 
 struct DictExpr : public Expr {
-    std::vector<std::pair<std::unique_ptr<Expr>, std::unique_ptr<Expr>>> pairs;
-    DictExpr(std::vector<std::pair<std::unique_ptr<Expr>, std::unique_ptr<Expr>>> p) 
-        : pairs(std::move(p)) {}
+    std::vector<std::pair<Node<Expr>, Node<Expr>>> pairs;
+    DictExpr(std::vector<std::pair<Node<Expr>, Node<Expr>>> p) 
+        : Expr(ExprKind::Dict), pairs(std::move(p)) {}
     void print() const override { std::cout << "{...}"; }
 };
 
 struct IndexExpr : public Expr {
-    std::unique_ptr<Expr> object;
-    std::unique_ptr<Expr> index; 
-    IndexExpr(std::unique_ptr<Expr> o, std::unique_ptr<Expr> i) 
-        : object(std::move(o)), index(std::move(i)) {}
+    Node<Expr> object;
+    Node<Expr> index; 
+    IndexExpr(Node<Expr> o, Node<Expr> i) 
+        : Expr(ExprKind::Index), object(std::move(o)), index(std::move(i)) {}
     void print() const override { 
         object->print(); 
         std::cout << "["; index->print(); std::cout << "]"; 
@@ -120,32 +179,46 @@ struct IndexExpr : public Expr {
 
 struct BinaryExpr : public Expr {
     char op;
-    std::unique_ptr<Expr> lhs, rhs;
-    BinaryExpr(char o, std::unique_ptr<Expr> l, std::unique_ptr<Expr> r)
-        : op(o), lhs(std::move(l)), rhs(std::move(r)) {}
+    Node<Expr> lhs, rhs;
+    BinaryExpr(char o, Node<Expr> l, Node<Expr> r)
+        : Expr(ExprKind::Binary), op(o), lhs(std::move(l)), rhs(std::move(r)) {}
     void print() const override {
         std::cout << "("; lhs->print(); std::cout << " " << op << " "; rhs->print(); std::cout << ")";
     }
 };
 
+// Unary minus. Evaluates like `0 - operand`, so anything but a number
+// negates to nil.
+struct NegateExpr : public Expr {
+    Node<Expr> operand;
+    NegateExpr(Node<Expr> o) : Expr(ExprKind::Negate), operand(std::move(o)) {}
+    void print() const override { std::cout << "(-"; operand->print(); std::cout << ")"; }
+};
+
 struct Stmt {
+    const StmtKind kind;
+    explicit Stmt(StmtKind k) : kind(k) {}
     virtual ~Stmt() = default;
     virtual void print(int indent = 0) = 0;
 };
 
 struct Program {
-    std::vector<std::unique_ptr<Stmt>> statements;
+    Arena arena; // Declared first so it outlives the nodes below
+    std::vector<Node<Stmt>> statements;
     void print() const { for (auto& stmt : statements) stmt->print(0); }
 };
 
 struct ClearStmt : public Stmt {
+    ClearStmt() : Stmt(StmtKind::Clear) {}
     void print(int indent = 0) override { std::cout << std::string(indent, ' ') << "ClearScreen\n"; }
 };
 
 struct SetStmt : public Stmt {
-    std::string name;
-    std::unique_ptr<Expr> expression;
-    SetStmt(const std::string& n, std::unique_ptr<Expr> e) : name(n), expression(std::move(e)) {}
+    Atom name;
+    Node<Expr> expression;
+    int depth = -1, slot = -1;
+    BinaryExpr* append = nullptr; // Set by the Resolver for `set s = s + x`
+    SetStmt(const std::string& n, Node<Expr> e) : Stmt(StmtKind::Set), name(n), expression(std::move(e)) {}
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Set: " << name << " = ";
         if(expression) expression->print(); std::cout << "\n";
@@ -153,12 +226,12 @@ struct SetStmt : public Stmt {
 };
 
 struct SetIndexStmt : public Stmt {
-    std::unique_ptr<Expr> list;   
-    std::unique_ptr<Expr> index; 
-    std::unique_ptr<Expr> value;  
+    Node<Expr> list;   
+    Node<Expr> index; 
+    Node<Expr> value;  
 
-    SetIndexStmt(std::unique_ptr<Expr> l, std::unique_ptr<Expr> i, std::unique_ptr<Expr> v)
-    : list(std::move(l)), index(std::move(i)), value(std::move(v)) {}
+    SetIndexStmt(Node<Expr> l, Node<Expr> i, Node<Expr> v)
+    : Stmt(StmtKind::SetIndex), list(std::move(l)), index(std::move(i)), value(std::move(v)) {}
 
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "SetIndex [...]\n";
@@ -166,9 +239,9 @@ struct SetIndexStmt : public Stmt {
 };
 
 struct WhileStmt : public Stmt {
-    std::unique_ptr<Expr> condition;
-    std::vector<std::unique_ptr<Stmt>> body;
-    WhileStmt(std::unique_ptr<Expr> cond) : condition(std::move(cond)) {}
+    Node<Expr> condition;
+    std::vector<Node<Stmt>> body;
+    WhileStmt(Node<Expr> cond) : Stmt(StmtKind::While), condition(std::move(cond)) {}
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "While\n";
         for (auto& s : body) s->print(indent + 2);
@@ -176,10 +249,10 @@ struct WhileStmt : public Stmt {
 };
 
 struct IfStmt : public Stmt {
-    std::unique_ptr<Expr> condition;
-    std::vector<std::unique_ptr<Stmt>> thenBranch;
-    std::vector<std::unique_ptr<Stmt>> elseBranch;
-    IfStmt(std::unique_ptr<Expr> cond) : condition(std::move(cond)) {}
+    Node<Expr> condition;
+    std::vector<Node<Stmt>> thenBranch;
+    std::vector<Node<Stmt>> elseBranch;
+    IfStmt(Node<Expr> cond) : Stmt(StmtKind::If), condition(std::move(cond)) {}
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "If\n";
         for (auto& s : thenBranch) s->print(indent + 2);
@@ -188,12 +261,13 @@ struct IfStmt : public Stmt {
 };
 
 struct ForStmt : public Stmt { 
-    std::string iteratorName;
-    std::unique_ptr<Expr> collection; 
-    std::vector<std::unique_ptr<Stmt>> body;
+    Atom iteratorName;
+    Node<Expr> collection; 
+    std::vector<Node<Stmt>> body;
+    int slot = -1; // Iterator slot in the enclosing scope
 
-    ForStmt(const std::string& iter, std::unique_ptr<Expr> col) 
-        : iteratorName(iter), collection(std::move(col)) {}
+    ForStmt(const std::string& iter, Node<Expr> col) 
+        : Stmt(StmtKind::For), iteratorName(iter), collection(std::move(col)) {}
         
     void print(int indent = 0) override { 
         std::cout << std::string(indent, ' ') << "For " << iteratorName << " in Expr\n";
@@ -202,10 +276,23 @@ struct ForStmt : public Stmt {
 };
 
 struct FuncDecl : public Stmt {
-    std::string name;
-    std::vector<std::string> params;
-    std::vector<std::unique_ptr<Stmt>> body;
-    FuncDecl(const std::string& n, std::vector<std::string> p) : name(n), params(std::move(p)) {}
+    // A variable of an enclosing function (or catch block) the body uses:
+    // its address from the frame that runs the declaration, and the slot
+    // of this function's frame that shares its cell.
+    struct Capture {
+        int depth, slot;
+        int target;
+    };
+
+    Atom name;
+    std::vector<Atom> params;
+    std::vector<Node<Stmt>> body;
+    std::shared_ptr<ScopeLayout> layout = std::make_shared<ScopeLayout>(); // Shared by every call frame
+    std::vector<Capture> captures; // Filled by the Resolver
+    // Keep the whole defining environment instead of captures. Cleared by
+    // the Resolver unless an import or extern block needs names it cannot see.
+    bool capturesEnv = true;
+    FuncDecl(const std::string& n, const std::vector<std::string>& p) : Stmt(StmtKind::Func), name(n), params(p.begin(), p.end()) {}
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Func " << name << "\n";
         for (auto& stmt : body) stmt->print(indent + 2);
@@ -214,11 +301,11 @@ struct FuncDecl : public Stmt {
 
  
 struct ClassDecl : public Stmt {
-    std::string name;
-    std::vector<std::unique_ptr<FuncDecl>> methods;  
+    Atom name;
+    std::vector<Node<FuncDecl>> methods;  
 
-    ClassDecl(std::string n, std::vector<std::unique_ptr<FuncDecl>> m) 
-    : name(n), methods(std::move(m)) {}
+    ClassDecl(std::string n, std::vector<Node<FuncDecl>> m) 
+    : Stmt(StmtKind::Class), name(n), methods(std::move(m)) {}
 
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Class " << name << "\n";
@@ -227,51 +314,52 @@ struct ClassDecl : public Stmt {
 };
 
 struct CallStmt : public Stmt {
-    std::string func;
-    std::vector<std::unique_ptr<Expr>> args;
-    CallStmt(const std::string& f, std::vector<std::unique_ptr<Expr>> a) : func(f), args(std::move(a)) {}
+    Atom func;
+    std::vector<Node<Expr>> args;
+    CallSite site;
+    CallStmt(const std::string& f, std::vector<Node<Expr>> a) : Stmt(StmtKind::Call), func(f), args(std::move(a)) {}
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Call " << func << "\n";
     }
 };
 
 struct UpdateStmt : public Stmt {
-    std::string name;
+    Atom name;
     std::string op;
-    UpdateStmt(const std::string& n, const std::string& o) : name(n), op(o) {}
+    UpdateStmt(const std::string& n, const std::string& o) : Stmt(StmtKind::Update), name(n), op(o) {}
     void print(int indent = 0) override { std::cout << std::string(indent, ' ') << "Update " << name << "\n"; }
 };
 
 struct PropertyStmt : public Stmt {
     std::string name;
     std::string value;
-    PropertyStmt(const std::string& n, const std::string& v) : name(n), value(v) {}
+    PropertyStmt(const std::string& n, const std::string& v) : Stmt(StmtKind::Property), name(n), value(v) {}
     void print(int indent = 0) override { std::cout << "Prop " << name << "\n"; }
 };
 
 struct AppDecl : public Stmt {
     std::string name;
-    std::vector<std::unique_ptr<Stmt>> body;
-    AppDecl(const std::string& n) : name(n) {}
+    std::vector<Node<Stmt>> body;
+    AppDecl(const std::string& n) : Stmt(StmtKind::App), name(n) {}
     void print(int indent = 0) override { std::cout << "App " << name << "\n"; for (auto& s : body) s->print(indent+2); }
 };
 
 struct WindowDecl : public Stmt {
     std::string name;
-    std::vector<std::unique_ptr<Stmt>> body;
-    WindowDecl(const std::string& n) : name(n) {}
+    std::vector<Node<Stmt>> body;
+    WindowDecl(const std::string& n) : Stmt(StmtKind::Window), name(n) {}
     void print(int indent = 0) override { std::cout << "Window " << name << "\n"; for (auto& s : body) s->print(indent+2); }
 };
 
 struct ConnectStmt : public Stmt {
     std::string source, event, target;
-    ConnectStmt(const std::string& s, const std::string& e, const std::string& t) : source(s), event(e), target(t) {}
+    ConnectStmt(const std::string& s, const std::string& e, const std::string& t) : Stmt(StmtKind::Connect), source(s), event(e), target(t) {}
     void print(int indent = 0) override { std::cout << "Connect\n"; }
 };
 
 struct ReturnStmt : public Stmt {
-	std::unique_ptr<Expr> value; 
-	ReturnStmt(std::unique_ptr<Expr> v) : value(std::move(v)) {} 
+	Node<Expr> value; 
+	ReturnStmt(Node<Expr> v) : Stmt(StmtKind::Return), value(std::move(v)) {} 
 	
 	void print(int indent = 0) override {
 		std::cout << std::string(indent, ' ') << "Return "; 
@@ -281,7 +369,7 @@ struct ReturnStmt : public Stmt {
 
 struct ImportStmt : public Stmt { 
 	std::string path; 
-	ImportStmt(std::string p) : path(p) {}
+	ImportStmt(std::string p) : Stmt(StmtKind::Import), path(p) {}
 	
 	void print(int indent = 0) override {
 		std::cout << std::string(indent, ' ') << "Import: " << path << "\n"; 
@@ -289,14 +377,15 @@ struct ImportStmt : public Stmt {
 }; 
 
 struct TryStmt : public Stmt {
-    std::vector<std::unique_ptr<Stmt>> tryBody;
-    std::vector<std::unique_ptr<Stmt>> catchBody;
-    std::string errorVar; 
+    std::vector<Node<Stmt>> tryBody;
+    std::vector<Node<Stmt>> catchBody;
+    Atom errorVar; 
+    std::shared_ptr<ScopeLayout> catchLayout = std::make_shared<ScopeLayout>();
 
-    TryStmt(std::vector<std::unique_ptr<Stmt>> tb, 
-            std::vector<std::unique_ptr<Stmt>> cb, 
+    TryStmt(std::vector<Node<Stmt>> tb, 
+            std::vector<Node<Stmt>> cb, 
             std::string ev) 
-    : tryBody(std::move(tb)), catchBody(std::move(cb)), errorVar(ev) {}
+    : Stmt(StmtKind::Try), tryBody(std::move(tb)), catchBody(std::move(cb)), errorVar(ev) {}
 
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Try\n";
@@ -308,18 +397,19 @@ struct TryStmt : public Stmt {
 
  
 struct NewExpr : public Expr {
-    std::string className;
-    std::vector<std::unique_ptr<Expr>> args;
+    Atom className;
+    std::vector<Node<Expr>> args;
+    MethodCache initCache;
     
-    NewExpr(std::string n, std::vector<std::unique_ptr<Expr>> a) 
-    : className(n), args(std::move(a)) {}
+    NewExpr(std::string n, std::vector<Node<Expr>> a) 
+    : Expr(ExprKind::New), className(n), args(std::move(a)) {}
     
     void print() const override { std::cout << "new " << className << "(...)"; }
 }; 
 
 struct ExprStmt : public Stmt {
-    std::unique_ptr<Expr> expression;
-    ExprStmt(std::unique_ptr<Expr> e) : expression(std::move(e)) {}
+    Node<Expr> expression;
+    ExprStmt(Node<Expr> e) : Stmt(StmtKind::Expr), expression(std::move(e)) {}
     
     void print(int indent = 0) override { 
         std::cout << std::string(indent, ' ') << "ExprStmt\n";
@@ -329,12 +419,14 @@ struct ExprStmt : public Stmt {
 };
 
 struct BreakStmt : public Stmt {
+    BreakStmt() : Stmt(StmtKind::Break) {}
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Break\n";
     }
 };
 
 struct ContinueStmt : public Stmt {
+    ContinueStmt() : Stmt(StmtKind::Continue) {}
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Continue\n";
     }
@@ -345,7 +437,7 @@ struct ExternStmt : public Stmt {
     std::string flags; 
     std::string code;
     
-    ExternStmt(std::string l, std::string f, std::string c) : lang(l), flags(f), code(std::move(c)) {}
+    ExternStmt(std::string l, std::string f, std::string c) : Stmt(StmtKind::Extern), lang(l), flags(f), code(std::move(c)) {}
 
     void print(int indent = 0) override {
         std::cout << std::string(indent, ' ') << "Extern \"" << lang << "\" Flags: [" << flags << "] {\n";
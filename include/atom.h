@@ -0,0 +1,59 @@
+#pragma once
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+// Interned identifier. Every distinct spelling is stored once in a global
+// symbol table together with its hash, so atoms compare by pointer and
+// hash without touching the characters. Interning happens when the parser
+// builds the AST; the table lives for the whole process.
+class Atom {
+public:
+    Atom() : entry(intern(std::string())) {}
+    explicit Atom(const std::string& text) : entry(intern(text)) {}
+    Atom(const char* text) : entry(intern(std::string(text))) {}
+
+    const std::string& str() const { return entry->first; }
+    operator const std::string&() const { return entry->first; }
+    const char* c_str() const { return entry->first.c_str(); }
+    bool empty() const { return entry->first.empty(); }
+    size_t hash() const { return entry->second; }
+
+    bool operator==(const Atom& other) const { return entry == other.entry; }
+    bool operator!=(const Atom& other) const { return entry != other.entry; }
+    bool operator==(const std::string& text) const { return entry->first == text; }
+    bool operator!=(const std::string& text) const { return entry->first != text; }
+    bool operator==(const char* text) const { return std::strcmp(entry->first.c_str(), text) == 0; }
+    bool operator!=(const char* text) const { return !(*this == text); }
+
+private:
+    using Entry = std::pair<const std::string, size_t>;
+    const Entry* entry;
+
+    static const Entry* intern(const std::string& text) {
+        static std::unordered_map<std::string, size_t> table;
+        auto it = table.find(text);
+        if (it == table.end()) it = table.emplace(text, std::hash<std::string>{}(text)).first;
+        return &*it;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Atom& atom) { return os << atom.str(); }
+inline std::string operator+(const std::string& lhs, const Atom& rhs) { return lhs + rhs.str(); }
+inline std::string operator+(const char* lhs, const Atom& rhs) { return lhs + rhs.str(); }
+inline std::string operator+(const Atom& lhs, const std::string& rhs) { return lhs.str() + rhs; }
+inline std::string operator+(const Atom& lhs, const char* rhs) { return lhs.str() + rhs; }
+
+// Names the runtime itself looks up on every method call
+namespace atoms {
+inline const Atom self("this");
+inline const Atom init("init");
+}
+
+namespace std {
+template <> struct hash<Atom> {
+    size_t operator()(const Atom& atom) const { return atom.hash(); }
+};
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "ast.h"
+
+// Instruction set of the stack VM (--engine=vm).
+// Operands follow the opcode inline; 16-bit operands are big-endian.
+enum class OpCode : uint8_t {
+    CONSTANT,       // u16 const       -> push constants[const]
+    NIL, TRUE, FALSE,
+    POP,
+
+    GET_VAR,        // u16 name        -> push env[name]
+    SET_VAR,        // u16 name        pop value, assign env[name]
+    GET_SLOT,       // u8 depth, u16 slot, u16 name   resolved GET_VAR
+    SET_SLOT,       // u8 depth, u16 slot, u16 name   resolved SET_VAR
+    APPEND_SLOT,    // u8 depth, u16 slot, u16 name   pop rhs, lhs; store lhs + rhs (set s = s + x)
+
+    BINARY,         // u8 op           pop rhs, lhs -> push (lhs op rhs)
+    NEGATE,         //                 pop operand -> push -operand
+    MAKE_LIST,      // u16 count       pop count items -> push list
+    MAKE_DICT,      // u16 count       pop count key/value pairs -> push dict
+    GET_INDEX,      //                 pop index, object -> push object[index]
+    SET_INDEX,      //                 pop value, index, list
+    GET_FIELD,      // u16 name, u16 cache   pop object -> push object.name
+    SET_FIELD,      // u16 name, u16 cache   pop value, object -> push value
+
+    CALL,           // u16 name, u16 site, u8 argc  pop args -> push result
+    CALL_STMT,      // u16 name, u16 site, u8 argc  pop args (statement form, no result)
+    INVOKE,         // u16 name, u16 cache, u8 argc  pop args, object -> push result
+    NEW,            // u16 name, u16 cache, u8 argc  pop args -> push instance
+
+    JUMP,           // u16 offset      forward
+    JUMP_IF_FALSE,  // u16 offset      pop condition
+    LOOP,           // u16 offset      backward
+
+    FOR_PREP,       // u16 name, u16 slot, u16 offset   pop collection; jump if not a list
+    FOR_NEXT,       // u16 name, u16 slot, u16 offset   advance iterator or jump when done
+
+    CLOSURE,        // u16 node        bind a FuncDecl to the current environment
+    EXEC_STMT,      // u16 fallback    run a statement on the tree walker
+    RETURN          //                 pop value, leave the current frame
+};
+
+// A statement the compiler hands back to the tree walker. Break/continue
+// raised inside it are redirected to the enclosing compiled loop.
+struct FallbackStmt {
+    Stmt* stmt;
+    int breakTarget = -1;
+    int continueTarget = -1;
+};
+
+struct Chunk {
+    std::vector<uint8_t> code;
+    std::vector<Obj> constants;
+    std::vector<Atom> names;
+    std::vector<FuncDecl*> functions;
+    std::vector<CallSite*> callSites; // Link caches live on the AST nodes
+    std::vector<MethodCache*> methodCaches;
+    std::vector<FieldCache*> fieldCaches;
+    std::vector<FallbackStmt> fallbacks;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "bytecode.h"
+
+// Lowers the AST produced by Parser::parse into bytecode for the VM.
+// Statements without a bytecode form are emitted as EXEC_STMT fallbacks.
+class Compiler {
+public:
+    std::unique_ptr<Chunk> compileProgram(const Program& program);
+    std::unique_ptr<Chunk> compileFunction(const FuncDecl& fn);
+
+private:
+    struct LoopContext {
+        size_t continueTarget;
+        std::vector<size_t> breakJumps;
+        std::vector<size_t> fallbacks;
+        explicit LoopContext(size_t target) : continueTarget(target) {}
+    };
+
+    Chunk* chunk = nullptr;
+    std::vector<LoopContext> loops;
+    std::unordered_map<Atom, uint16_t> nameSlots;
+
+    void block(const std::vector<Node<Stmt>>& stmts);
+    void statement(Stmt* stmt);
+    void expression(Expr* expr);
+    void fallback(Stmt* stmt);
+    void variable(OpCode byName, OpCode bySlot, Atom name, int depth, int slot);
+    void call(Atom func, const std::vector<Node<Expr>>& args, OpCode op,
+              CallSite* site = nullptr, MethodCache* cache = nullptr);
+
+    void emitByte(uint8_t byte);
+    void emitOp(OpCode op);
+    void emitShort(uint16_t value);
+    size_t emitJump(OpCode op);
+    void patchJump(size_t offset);
+    void emitLoop(size_t target);
+    uint16_t makeConstant(const Obj& value);
+    uint16_t identifier(Atom name);
+    uint16_t fieldCache(FieldCache* cache);
+};
+
+void disassembleChunk(const Chunk& chunk, const std::string& title);
@@ -1,34 +1,185 @@
 #pragma once
 #include "types.h"
+#include "atom.h"
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include <memory>
 
+// Name -> slot map shared by every frame of one scope (a function body, a
+// catch block or the global scope). The Resolver fills it ahead of time;
+// names defined dynamically (e.g. by import) are appended on the fly.
+struct ScopeLayout {
+    std::unordered_map<Atom, int> slots;
+    std::vector<Atom> names;
+
+    int lookup(Atom name) const {
+        auto it = slots.find(name);
+        return it == slots.end() ? -1 : it->second;
+    }
+
+    int declare(Atom name) {
+        auto [it, inserted] = slots.try_emplace(name, (int)names.size());
+        if (inserted) names.push_back(name);
+        return it->second;
+    }
+};
+
+// Free-list allocator for call frames. allocate_shared rebinds it to the
+// combined control block + Environment, so a call takes one block off the
+// list instead of going to malloc. A frame captured by a closure keeps its
+// block until the last reference drops; only then is it recycled.
+template <typename T>
+struct FrameAllocator {
+    using value_type = T;
+
+    FrameAllocator() = default;
+    template <typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        auto& list = freeList().blocks;
+        if (n == 1 && !list.empty()) {
+            T* block = list.back();
+            list.pop_back();
+            return block;
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, size_t n) {
+        auto& list = freeList().blocks;
+        if (n == 1 && list.size() < MAX_FREE) list.push_back(block);
+        else ::operator delete(block);
+    }
+
+    template <typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+
+private:
+    static constexpr size_t MAX_FREE = 1024;
+
+    struct FreeList {
+        std::vector<T*> blocks;
+        ~FreeList() { for (T* block : blocks) ::operator delete(block); }
+    };
+    static FreeList& freeList() { static FreeList list; return list; }
+};
+
+// A variable captured by a closure. The defining frame and every closure
+// that captured it share the cell, so assignments on either side are seen
+// by both, and the closure keeps only this variable alive, not the frame.
+struct Cell {
+    Obj value;
+    bool bound = false;
+};
+
 struct Environment {
+    struct Slot : Cell {
+        std::shared_ptr<Cell> cell; // Set once captured; the value then lives there
+    };
+
     std::shared_ptr<Environment> enclosing; // Berubah jadi shared_ptr
-    std::unordered_map<std::string, Obj> values;
+    std::shared_ptr<ScopeLayout> layout;
+    std::vector<Slot> slots;
 
-    Environment(std::shared_ptr<Environment> enc = nullptr) : enclosing(enc) {}
+    // Frames come from the pool; use this rather than make_shared
+    static std::shared_ptr<Environment> make(std::shared_ptr<Environment> enc = nullptr,
+                                             std::shared_ptr<ScopeLayout> l = nullptr) {
+        return std::allocate_shared<Environment>(FrameAllocator<Environment>(), std::move(enc), std::move(l));
+    }
 
-    void define(const std::string& name, Obj val) {
-        values[name] = val;
+    // Slot vectors are recycled with the frames, so a call reuses the
+    // capacity of an earlier one instead of allocating its own.
+    Environment(std::shared_ptr<Environment> enc = nullptr, std::shared_ptr<ScopeLayout> l = nullptr)
+        : enclosing(std::move(enc)), layout(l ? std::move(l) : std::make_shared<ScopeLayout>()) {
+        auto& spare = spareSlots();
+        if (!spare.empty()) {
+            slots = std::move(spare.back());
+            spare.pop_back();
+        }
+        slots.resize(layout->names.size());
     }
 
-    Obj get(const std::string& name) {
-        if (values.count(name)) return values[name];
-        if (enclosing) return enclosing->get(name);
-        return Obj();  
+    ~Environment() {
+        slots.clear(); // May release closures, and with them other frames
+        auto& spare = spareSlots();
+        if (spare.size() < MAX_SPARE_SLOTS) spare.push_back(std::move(slots));
     }
 
-    void assign(const std::string& name, Obj val) {
-        if (values.count(name)) {
-            values[name] = val;
-            return;
+    void define(Atom name, Obj val) {
+        bind(layout->declare(name), std::move(val));
+    }
+
+    static Cell& storage(Slot& slot) { return slot.cell ? *slot.cell : slot; }
+
+    void bind(int slot, Obj val) {
+        if (slot >= (int)slots.size()) slots.resize(layout->names.size());
+        Cell& cell = storage(slots[slot]);
+        cell.value = std::move(val);
+        cell.bound = true;
+    }
+
+    // Resolved access: the slot 'depth' scopes up, or nullptr if that frame
+    // has not bound the name yet (callers then fall back to get/assign).
+    Obj* slotAt(int depth, int slot) {
+        Environment* env = this;
+        while (depth-- > 0) env = env->enclosing.get();
+        if (slot >= (int)env->slots.size()) return nullptr;
+        Cell& cell = storage(env->slots[slot]);
+        return cell.bound ? &cell.value : nullptr;
+    }
+
+    // Moves the slot 'depth' scopes up into a cell (once) and returns it, so
+    // a closure can share the variable. Works before the slot is bound.
+    std::shared_ptr<Cell> capture(int depth, int slot) {
+        Environment* env = this;
+        while (depth-- > 0) env = env->enclosing.get();
+        if (slot >= (int)env->slots.size()) env->slots.resize(env->layout->names.size());
+        Slot& s = env->slots[slot];
+        if (!s.cell) {
+            s.cell = std::make_shared<Cell>(Cell{std::move(s.value), s.bound});
+            s.value = Obj();
+            s.bound = false;
         }
-        if (enclosing) {
-            enclosing->assign(name, val);
+        return s.cell;
+    }
+
+    // Gives a fresh call frame the cells its closure captured
+    void attach(int slot, std::shared_ptr<Cell> cell) {
+        if (slot >= (int)slots.size()) slots.resize(layout->names.size());
+        slots[slot].cell = std::move(cell);
+    }
+
+    Obj* find(Atom name) {
+        for (Environment* env = this; env; env = env->enclosing.get()) {
+            int slot = env->layout->lookup(name);
+            if (slot < 0 || slot >= (int)env->slots.size()) continue;
+            Cell& cell = storage(env->slots[slot]);
+            if (cell.bound) return &cell.value;
+        }
+        return nullptr;
+    }
+
+    Obj get(Atom name) {
+        if (Obj* val = find(name)) return *val;
+        return Obj();
+    }
+
+    void assign(Atom name, Obj val) {
+        if (Obj* slot = find(name)) {
+            *slot = std::move(val);
             return;
         }
-        values[name] = val;  
+        Environment* root = this;
+        while (root->enclosing) root = root->enclosing.get();
+        root->define(name, std::move(val));
+    }
+
+private:
+    static constexpr size_t MAX_SPARE_SLOTS = 1024;
+
+    static std::vector<std::vector<Slot>>& spareSlots() {
+        static std::vector<std::vector<Slot>> spare;
+        return spare;
     }
-};
\ No newline at end of file
+};
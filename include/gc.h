@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "types.h"
+
+// Cycle collector for the runtime heap. Lists, dicts, instances and
+// functions are still freed by their refcounts the moment they become
+// unreachable; the collector handles what refcounts cannot: a cycle
+// (an instance holding itself, a closure stored in the frame it captured)
+// that nothing outside the cycle refers to.
+//
+// Roots are not enumerated. An object is a root when its refcount is
+// higher than the number of references found inside the traced heap, so
+// globalEnv, currentEnv, the VM stack and Values held on the native call
+// stack all count without having to be registered.
+class Collector {
+public:
+    struct Stats {
+        size_t tracked = 0;     // Registered objects still alive
+        size_t collections = 0;
+        size_t freed = 0;       // Objects released from cycles, in total
+        size_t lastFreed = 0;
+    };
+
+    static Collector& instance();
+
+    // Every List, Dict, LinkInstance and LinkFunction the runtime creates
+    // is registered here. May run a collection when enough objects have
+    // been registered since the last one.
+    template <typename T>
+    std::shared_ptr<T> track(std::shared_ptr<T> object) {
+        entries.push_back({kindOf(object.get()), object.get(), object});
+        if (++sinceCollect >= threshold) collect();
+        return object;
+    }
+
+    size_t collect(); // Returns the number of objects released
+    Stats stats();
+
+private:
+    enum class Kind : uint8_t { List, Dict, Instance, Function, Env, Cell };
+
+    struct Entry {
+        Kind kind;
+        void* object;
+        std::weak_ptr<void> ref; // Does not keep the object alive
+    };
+
+    static constexpr size_t MIN_THRESHOLD = 10000;
+
+    std::vector<Entry> entries;
+    size_t sinceCollect = 0;
+    size_t threshold = MIN_THRESHOLD;
+    Stats totals;
+
+    static Kind kindOf(const List*) { return Kind::List; }
+    static Kind kindOf(const Dict*) { return Kind::Dict; }
+    static Kind kindOf(const LinkInstance*) { return Kind::Instance; }
+    static Kind kindOf(const LinkFunction*) { return Kind::Function; }
+
+    template <typename Visit> static void forEachChild(Kind kind, void* object, Visit&& visit);
+    void prune();
+};
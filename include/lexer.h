@@ -1,12 +1,14 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
+#include <deque>
 #include "token.h"
 
 class Lexer {
 public:
     explicit Lexer(const std::string& source);
-    std::vector<Token> tokenize();
+    Token next(); // Scans only as far as the next token; EOF_TOKEN repeats at the end
 
 private:
     const std::string& src;
@@ -15,6 +17,13 @@ private:
     int column;
 
     std::vector<int> indentStack;
+    std::deque<Token> pending; // Scanned but not yet handed out (NEWLINE + DEDENTs, extern blocks)
+
+    // Owned text of the last few escaped string literals. Older ones are
+    // dropped, which is safe because the parser copies a token's text
+    // before it looks more than one token ahead.
+    static constexpr size_t DECODED_KEEP = 4;
+    std::deque<std::string> decoded;
 
     char peek() const;
     char advance();
@@ -22,12 +31,14 @@ private:
 
     void skipWhitespace();
     void skipComment();
-    Token makeToken(TokenType type, const std::string& value = "");
+    Token makeToken(TokenType type, std::string_view value = {});
+    std::string_view text(size_t start) const { return std::string_view(src).substr(start, pos - start); }
 
     Token identifier();
-    Token stringLiteral();
+    Token stringLiteral(bool decode = true);
     Token number(); 
 
-    void handleIndentation(std::vector<Token>& tokens);
+    void scan();
+    void handleIndentation();
 };
 
@@ -1,12 +1,34 @@
 // std_string.h
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace SysString {
+    // Search core shared by every scanning helper. An empty needle matches
+    // at 'from' in find and never in count/findAll.
+    size_t find(std::string_view str, std::string_view needle, size_t from = 0);
+    size_t count(std::string_view str, std::string_view needle);
+    std::vector<size_t> findAll(std::string_view str, std::string_view needle);
+
+    // Views into the input, so callers can keep the pieces as slices
+    std::string_view trimView(std::string_view str);
+    std::vector<std::string_view> splitView(std::string_view str, std::string_view delimiter);
+    std::string_view substringView(std::string_view str, int start, int length);
+
+    // Number <-> text on to_chars/from_chars: no exceptions, locale or
+    // temporary strings. Parsing skips leading whitespace and a '+' like
+    // stoi/stod and stops at the first character that does not fit; it
+    // returns false (leaving out alone) when there is no number or it
+    // is out of range.
+    bool parseInt(std::string_view str, int& out);
+    bool parseDouble(std::string_view str, double& out);
+    void appendInt(std::string& out, int value);
+    void appendDouble(std::string& out, double value); // 6 decimals, trailing zeros dropped
+
     std::string trim(const std::string& str);
-    std::string replace(std::string str, const std::string& from, const std::string& to);
-    std::vector<std::string> split(std::string str, const std::string& delimiter);
+    std::string replace(const std::string& str, const std::string& from, const std::string& to);
+    std::vector<std::string> split(const std::string& str, const std::string& delimiter);
     std::string merge(const std::vector<std::string>& list, const std::string& delimiter);
     
     std::string substring(const std::string& str, int start, int length);
@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "runtime.h"
+#include "link_str.h"
+
+// Compile-time glue between script values and plain C++ functions.
+// bind<&SysGui::drawRect>("gui_rect") instantiates nativeThunk for that
+// exact function: argument unpacking and result boxing are derived from
+// its signature and the call is direct, so the registry only stores a
+// function pointer.
+
+// Loose numeric coercion shared by the hand-written natives
+inline int nativeToInt(const Obj& o) {
+    if (o.isInt()) return o.asInt();
+    if (o.isDouble()) return (int)o.asDouble();
+    int value = 0;
+    if (o.isString()) SysString::parseInt(o.asLinkString().view(), value);
+    return value;
+}
+
+inline double nativeToDouble(const Obj& o) {
+    if (o.isNumber()) return o.asNumber();
+    double value = 0.0;
+    if (o.isString()) SysString::parseDouble(o.asLinkString().view(), value);
+    return value;
+}
+
+template <class T> struct NativeArg;
+template <> struct NativeArg<int> {
+    static int get(Runtime&, const Obj& o) { return nativeToInt(o); }
+};
+template <> struct NativeArg<double> {
+    static double get(Runtime&, const Obj& o) { return nativeToDouble(o); }
+};
+template <> struct NativeArg<float> {
+    static float get(Runtime&, const Obj& o) { return (float)nativeToDouble(o); }
+};
+template <> struct NativeArg<bool> {
+    static bool get(Runtime& rt, const Obj& o) { return rt.isTruthy(o); }
+};
+// String arguments share the caller's buffer; the LinkString temporary
+// lives until the native returns and converts to const std::string&
+template <> struct NativeArg<std::string> {
+    static LinkString get(Runtime& rt, const Obj& o) { return rt.toLinkString(o); }
+};
+
+template <class R> struct NativeResult {
+    static Obj box(R v) { return Obj(v); }
+};
+template <> struct NativeResult<float> {
+    static Obj box(float v) { return Obj((double)v); }
+};
+
+template <class Sig> struct NativeSignature;
+template <class R, class... A> struct NativeSignature<R (*)(A...)> {
+    using Result = R;
+    using Args = std::tuple<std::decay_t<A>...>;
+    static constexpr size_t arity = sizeof...(A);
+};
+
+template <auto Fn, size_t... I>
+Obj callNative(Runtime& rt, ArgSpan args, std::index_sequence<I...>) {
+    using Sig = NativeSignature<decltype(Fn)>;
+    using R = typename Sig::Result;
+    if constexpr (std::is_void_v<R>) {
+        Fn(NativeArg<std::tuple_element_t<I, typename Sig::Args>>::get(rt, args[I])...);
+        return Obj(0);
+    } else {
+        return NativeResult<R>::box(Fn(NativeArg<std::tuple_element_t<I, typename Sig::Args>>::get(rt, args[I])...));
+    }
+}
+
+// Too few arguments skips the call and yields the zero value of the result
+template <auto Fn>
+Obj nativeThunk(Runtime& rt, ArgSpan args) {
+    using Sig = NativeSignature<decltype(Fn)>;
+    if (args.size() < Sig::arity) {
+        if constexpr (std::is_void_v<typename Sig::Result>) return Obj(0);
+        else return NativeResult<typename Sig::Result>::box(typename Sig::Result{});
+    }
+    return callNative<Fn>(rt, args, std::make_index_sequence<Sig::arity>{});
+}
+
+template <auto Fn>
+void Runtime::bind(const std::string& name) {
+    nativeRegistry[name] = &nativeThunk<Fn>;
+}
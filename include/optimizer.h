@@ -0,0 +1,31 @@
+#pragma once
+#include "ast.h"
+
+class Runtime;
+
+// Pass that runs between Parser::parse and the Resolver. Folds operators
+// whose operands are all literals into a single literal, evaluated with
+// Runtime::binaryOp so the result is exactly what execution would produce.
+// Operations that evaluate to nil are left in place. Multiplying or
+// dividing by 1 is dropped where the other operand is known to be a
+// number or nil; see binary().
+class Optimizer {
+public:
+    explicit Optimizer(Runtime& runtime);
+    void optimize(Program& program);
+
+private:
+    Runtime& rt;
+    Arena* arena = nullptr;
+
+    void block(std::vector<Node<Stmt>>& stmts);
+    void statement(Stmt* stmt);
+    void expression(Node<Expr>& expr);
+    void binary(Node<Expr>& expr);
+    void negate(Node<Expr>& expr);
+
+    static bool isNumberOrNil(const Expr* expr);
+    static bool isLiteral(const Expr* expr);
+    Obj literalValue(const Expr* expr) const;
+    Node<Expr> makeLiteral(const Obj& value);
+};
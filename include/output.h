@@ -0,0 +1,41 @@
+#pragma once
+#include <streambuf>
+#include <string>
+
+// Runtime-owned stdout buffer. std::cout is pointed at it, so print,
+// io.write("stdout"), term.* and error messages all reach the terminal
+// in large writes instead of one syscall per call.
+//
+//   Buffered    flush when full, on io.flush, before blocking or exiting
+//   Line        as Buffered, and also at every newline (stdout is a TTY)
+//   Unbuffered  flush after every write (--unbuffered)
+//
+// std::cin and std::cerr are tied to std::cout, so reading input or
+// writing an error flushes pending output first.
+class OutputBuffer : public std::streambuf {
+public:
+    enum class Mode { Buffered, Line, Unbuffered };
+
+    static OutputBuffer& instance();
+
+    void install(Mode mode); // Redirects std::cout to this buffer
+    static Mode defaultMode(); // Line on a terminal, Buffered otherwise
+    void flush();
+
+    ~OutputBuffer() override;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    static constexpr size_t CAPACITY = 64 * 1024;
+
+    std::string pending;
+    Mode mode = Mode::Buffered;
+    std::streambuf* previous = nullptr;
+
+    OutputBuffer();
+    void afterWrite(const char* s, size_t n);
+};
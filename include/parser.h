@@ -2,52 +2,62 @@
 #include <vector>
 #include <memory>
 #include "token.h"
+#include "lexer.h"
 #include "ast.h"
 
 class Parser {
 public:
-    Parser(const std::vector<Token>& tokens);
+    Parser(Lexer& lexer);
     std::unique_ptr<Program> parse();
 
 private:
-    const std::vector<Token>& tokens;
+    // Tokens are pulled from the lexer one at a time. The ring holds the
+    // previous token and the current one; a reference returned by
+    // advance() or consume() stays valid until the next advance.
+    static constexpr size_t RING = 2;
+    Lexer& lexer;
+    Token ring[RING] = {};
     size_t current;
+    Arena* arena = nullptr; // The Program being parsed owns the nodes
+
+    template <typename T, typename... Args>
+    Node<T> make(Args&&... args) { return Node<T>(arena->create<T>(std::forward<Args>(args)...)); }
 
     const Token& peek() const;
     const Token& advance();
     bool match(TokenType type);
     const Token& consume(TokenType type, const std::string& err);
-    const Token& previous() const { return tokens[current - 1]; }
+    const Token& previous() const { return ring[(current - 1) % RING]; }
 
-    std::unique_ptr<Stmt> parseStatement();
-    std::unique_ptr<AppDecl> parseApp();
-    std::unique_ptr<WindowDecl> parseWindow();
-    std::unique_ptr<FuncDecl> parseFunc();
+    Node<Stmt> parseStatement();
+    Node<AppDecl> parseApp();
+    Node<WindowDecl> parseWindow();
+    Node<FuncDecl> parseFunc();
     
-    std::unique_ptr<Stmt> parseClass();
-    std::unique_ptr<Stmt> parseFor(); 
-    std::unique_ptr<Stmt> parseTry();
-    std::unique_ptr<Stmt> parseWhile(); 
-    std::unique_ptr<Stmt> parseIf(); 
-    std::unique_ptr<Stmt> parseSet();
-    std::unique_ptr<Stmt> parseReturn();
+    Node<Stmt> parseClass();
+    Node<Stmt> parseFor(); 
+    Node<Stmt> parseTry();
+    Node<Stmt> parseWhile(); 
+    Node<Stmt> parseIf(); 
+    Node<Stmt> parseSet();
+    Node<Stmt> parseReturn();
 	
     // Expression Hierarchy (Updated for Logic Ops)
-    std::unique_ptr<Expr> parseExpression();
-    std::unique_ptr<Expr> parseLogicOr();
-    std::unique_ptr<Expr> parseLogicAnd();
-    std::unique_ptr<Expr> parseEquality();
-    std::unique_ptr<Expr> parseBitwise(); 
+    Node<Expr> parseExpression();
+    Node<Expr> parseLogicOr();
+    Node<Expr> parseLogicAnd();
+    Node<Expr> parseEquality();
+    Node<Expr> parseBitwise(); 
     
-    std::unique_ptr<Expr> parseAdditive();
-    std::unique_ptr<Expr> parseTerm();
-    std::unique_ptr<Expr> parseUnary(); 
-    std::unique_ptr<Expr> parsePostfix(); 
-    std::unique_ptr<Expr> parsePrimary();
+    Node<Expr> parseAdditive();
+    Node<Expr> parseTerm();
+    Node<Expr> parseUnary(); 
+    Node<Expr> parsePostfix(); 
+    Node<Expr> parsePrimary();
     
-    std::vector<std::unique_ptr<Expr>> parseArguments();
-    std::unique_ptr<CallStmt> parseCall();
-    std::unique_ptr<ConnectStmt> parseConnect();
+    std::vector<Node<Expr>> parseArguments();
+    Node<CallStmt> parseCall();
+    Node<ConnectStmt> parseConnect();
 
     bool isAtEnd() const;
 };
@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "env.h"
+
+// Pass that runs between Parser::parse and execution. Annotates variable
+// reads, 'set' targets and loop iterators with a (depth, slot) address so
+// the engines index frames instead of hashing names at every access.
+// Declarations are hoisted per scope; a slot that is not bound yet at
+// runtime falls back to the by-name lookup, which keeps the old semantics.
+//
+// Functions are closure-converted: a variable of an enclosing function is
+// given a slot in the inner function's own frame, listed in
+// FuncDecl::captures, and shared through a Cell. The inner frame's parent
+// is then the global frame, so a closure does not keep its defining scope
+// chain alive.
+class Resolver {
+public:
+    explicit Resolver(std::shared_ptr<ScopeLayout> globals);
+    void resolve(Program& program);
+
+private:
+    struct Scope {
+        ScopeLayout* layout;
+        Scope* parent;
+        bool dynamic = false; // Contains an import, so it may gain names at runtime
+        FuncDecl* function = nullptr; // Set on the top scope of a function body
+    };
+
+    std::shared_ptr<ScopeLayout> globals;
+    Scope* globalScope = nullptr;
+
+    void declare(const std::vector<Node<Stmt>>& stmts, Scope& scope);
+    void block(const std::vector<Node<Stmt>>& stmts, Scope& scope);
+    void statement(Stmt* stmt, Scope& scope);
+    void expression(Expr* expr, Scope& scope);
+    void function(FuncDecl* fn, Scope& parent, bool isMethod);
+    Scope* lookup(Atom name, Scope& scope, int& depth, int& slot);
+    static bool containsExtern(const std::vector<Node<Stmt>>& stmts);
+};
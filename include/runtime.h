@@ -13,10 +13,11 @@
 #include "env.h"
 #include "parser.h" 
 
-// Native Function type definition
-using NativeFn = std::function<Obj(const std::vector<Obj>&)>;
-
 class Runtime {
+    friend class VM; // Bytecode engine shares the environment and registries
+    friend class Optimizer; // Folds constants with the same operator semantics
+    template <class T> friend struct NativeArg;
+
 private:
     std::shared_ptr<Environment> globalEnv;
     std::shared_ptr<Environment> currentEnv;
@@ -27,22 +28,66 @@ private:
 
     std::vector<std::unique_ptr<Program>> loadedPrograms;
 
+    // Reusable argument stack. Calls evaluate their arguments onto it and
+    // hand natives an ArgSpan instead of building a std::vector per call.
+    std::vector<Obj> argStack;
+
+    struct ArgFrame {
+        Runtime& rt;
+        size_t base;
+
+        ArgFrame(Runtime& runtime, const std::vector<Node<Expr>>& exprs)
+            : rt(runtime), base(runtime.argStack.size()) {
+            for (auto& e : exprs) {
+                Obj val = rt.evaluateExpr(e.get());
+                rt.argStack.push_back(std::move(val));
+            }
+        }
+        ~ArgFrame() { rt.argStack.resize(base); }
+
+        // Only valid until the next call pushes onto the stack
+        ArgSpan span() const { return {rt.argStack.data() + base, rt.argStack.size() - base}; }
+        size_t size() const { return rt.argStack.size() - base; }
+    };
+
     // Helper Functions
     void initNativeFunctions();
+    template <auto Fn> void bind(const std::string& name); // Defined in native_bind.h
     std::string objToString(const Obj& o);
+    void appendToString(std::string& out, const Obj& o);
+    LinkString toLinkString(const Obj& o); // Shares the buffer when o is a string
     std::string getAnsiColor(const std::string& color);
     void printObj(const Obj& val);
     
     // Logic Helper
     bool isTruthy(const Obj& o);
-    FuncDecl* findMethod(LinkClass* klass, const std::string& name);
+    FuncDecl* findMethod(LinkClass* klass, Atom name);
+    FuncDecl* cachedMethod(MethodCache& cache, const std::shared_ptr<LinkClass>& klass, Atom name);
+
+    // Call-site linking (shared by the tree walker and the VM)
+    NativeFn linkNative(CallSite& site, const std::string& name);
+    Obj lookupCallee(const CallSite& site, Atom name);
+
+    // Closures (shared by the tree walker and the VM)
+    std::shared_ptr<LinkFunction> makeClosure(FuncDecl* fn);
+    std::shared_ptr<Environment> callFrame(const LinkFunction& fn);
+
+    // Operator & access semantics (shared by the tree walker and the VM)
+    Obj binaryOp(char op, const Obj& left, const Obj& right);
+    Obj negate(const Obj& operand);
+    void assignConcat(int depth, int slot, Atom name, Obj left, const Obj& right);
+    Obj indexGet(const Obj& object, const Obj& index);
+    void indexSet(const Obj& list, const Obj& index, const Obj& val);
+    Obj getProperty(const Obj& obj, Atom name, FieldCache* cache = nullptr);
+    bool setProperty(const Obj& obj, Atom name, const Obj& val, FieldCache* cache = nullptr);
 
 public:
     Runtime(); // Constructor
 
     // Main execution function
     void run(const std::string& source, bool debug);
-    void runStatement(Stmt* stmt);
+    Completion runStatement(Stmt* stmt);
+    Completion runBlock(const std::vector<Node<Stmt>>& stmts);
     Obj evaluateExpr(Expr* expr);
     void execute(std::unique_ptr<Program> program); 
 };
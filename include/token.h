@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 enum class TokenType {
     // Keywords
@@ -33,9 +34,14 @@ enum class TokenType {
     LE, GE   // <=, >= 
 };
 
+// value points into the source text, or into the Lexer for literals that
+// had escapes decoded. The source must outlive the tokens; decoded text
+// lives while the parser holds the token (see Lexer::decoded).
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
     int line;
     int column;
+
+    std::string text() const { return std::string(value); }
 };
@@ -1,11 +1,13 @@
 #pragma once
 #include <variant>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <unordered_map>
 #include <iostream>
 #include "os.h" 
+#include "atom.h"
 
 struct Value;
 struct Stmt;        
@@ -14,17 +16,81 @@ struct LinkInstance;
 
 struct FuncDecl;           
 struct Environment;        
+struct Cell;
 
 struct LinkFunction {
     FuncDecl* declaration;
     std::shared_ptr<Environment> closure;
+    std::vector<std::shared_ptr<Cell>> upvalues; // Captured variables, in FuncDecl::captures order
 };
 
+// String payload of Value: an immutable buffer shared by every copy, so
+// passing or storing a string only bumps a refcount. Operations that
+// produce a different string build a new buffer instead of writing; the
+// one exception is tryAppend on a buffer nobody else can see.
+//
+// A handle may also be a slice (offset + length) of a parent buffer, as
+// made by str.sub, str.trim and str.split. view() reads a slice in place;
+// str() copies it into a buffer of its own the first time it is needed.
+class LinkString {
+public:
+    LinkString() : buf(emptyBuffer()) {}
+    LinkString(std::string s) : buf(std::make_shared<std::string>(std::move(s))), len(buf->size()) {}
+    LinkString(const char* s) : LinkString(std::string(s)) {}
+
+    const std::string& str() const {
+        if (isSlice()) {
+            buf = std::make_shared<std::string>(buf->data() + off, len);
+            off = 0;
+        }
+        return *buf;
+    }
+    operator const std::string&() const { return str(); }
+    std::string_view view() const { return std::string_view(buf->data() + off, len); }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    bool sameBuffer(const LinkString& other) const {
+        return buf == other.buf && off == other.off && len == other.len;
+    }
+
+    // part must lie inside view(); the result shares this buffer
+    LinkString slice(std::string_view part) const {
+        if (part.empty()) return LinkString();
+        LinkString s(*this);
+        s.off = off + (size_t)(part.data() - view().data());
+        s.len = part.size();
+        return s;
+    }
+
+    // Appends in place (amortized O(1)) when this handle holds the only
+    // reference to a whole buffer; otherwise leaves it alone and returns false
+    bool tryAppend(std::string_view tail) {
+        if (buf.use_count() != 1 || isSlice()) return false;
+        buf->append(tail);
+        len = buf->size();
+        return true;
+    }
+
+private:
+    mutable std::shared_ptr<std::string> buf;
+    mutable size_t off = 0;
+    size_t len = 0;
+
+    bool isSlice() const { return off != 0 || len != buf->size(); }
+
+    static const std::shared_ptr<std::string>& emptyBuffer() {
+        static const auto none = std::make_shared<std::string>();
+        return none;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const LinkString& s) { return os << s.view(); }
+
 using List = std::vector<Value>;
 using Dict = std::unordered_map<std::string, Value>;
 struct Value {
     using ValVariant = std::variant<
-        std::monostate, int, double, std::string, char, bool, 
+        std::monostate, int, double, LinkString, char, bool, 
         std::shared_ptr<List>, std::shared_ptr<Dict>,
         std::shared_ptr<LinkClass>, std::shared_ptr<LinkInstance>,
         std::shared_ptr<LinkFunction> // <--- New data type (Function)
@@ -35,8 +101,9 @@ struct Value {
     Value() : as(std::monostate{}) {}
     Value(int v) : as(v) {}
     Value(double v) : as(v) {}
-    Value(std::string v) : as(v) {}
-    Value(const char* v) : as(std::string(v)) {} 
+    Value(std::string v) : as(LinkString(std::move(v))) {}
+    Value(LinkString v) : as(std::move(v)) {}
+    Value(const char* v) : as(LinkString(v)) {} 
     Value(char v) : as(v) {}
     Value(bool v) : as(v) {}
     Value(std::shared_ptr<List> v) : as(v) {}
@@ -44,21 +111,92 @@ struct Value {
     Value(std::shared_ptr<LinkClass> v) : as(v) {}
     Value(std::shared_ptr<LinkInstance> v) : as(v) {}
     Value(std::shared_ptr<LinkFunction> v) : as(v) {} // <--- Constructor baru
+
+    // Accessor API. Code written against it instead of std::get does not
+    // depend on the storage layout, so the variant can be swapped for a
+    // packed encoding later.
+    bool isNil() const      { return std::holds_alternative<std::monostate>(as); }
+    bool isInt() const      { return std::holds_alternative<int>(as); }
+    bool isDouble() const   { return std::holds_alternative<double>(as); }
+    bool isNumber() const   { return isInt() || isDouble(); }
+    bool isString() const   { return std::holds_alternative<LinkString>(as); }
+    bool isChar() const     { return std::holds_alternative<char>(as); }
+    bool isBool() const     { return std::holds_alternative<bool>(as); }
+    bool isList() const     { return std::holds_alternative<std::shared_ptr<List>>(as); }
+    bool isDict() const     { return std::holds_alternative<std::shared_ptr<Dict>>(as); }
+    bool isClass() const    { return std::holds_alternative<std::shared_ptr<LinkClass>>(as); }
+    bool isInstance() const { return std::holds_alternative<std::shared_ptr<LinkInstance>>(as); }
+    bool isFunction() const { return std::holds_alternative<std::shared_ptr<LinkFunction>>(as); }
+
+    int asInt() const                   { return std::get<int>(as); }
+    double asDouble() const             { return std::get<double>(as); }
+    double asNumber() const             { return isInt() ? (double)asInt() : asDouble(); }
+    const std::string& asString() const { return std::get<LinkString>(as).str(); }
+    const LinkString& asLinkString() const { return std::get<LinkString>(as); }
+    char asChar() const                 { return std::get<char>(as); }
+    bool asBool() const                 { return std::get<bool>(as); }
+    const std::shared_ptr<List>& asList() const             { return std::get<std::shared_ptr<List>>(as); }
+    const std::shared_ptr<Dict>& asDict() const             { return std::get<std::shared_ptr<Dict>>(as); }
+    const std::shared_ptr<LinkClass>& asClass() const       { return std::get<std::shared_ptr<LinkClass>>(as); }
+    const std::shared_ptr<LinkInstance>& asInstance() const { return std::get<std::shared_ptr<LinkInstance>>(as); }
+    const std::shared_ptr<LinkFunction>& asFunction() const { return std::get<std::shared_ptr<LinkFunction>>(as); }
 };
 
 using Obj = Value;
+
+// Read-only view of call arguments. They live on the caller's argument
+// stack, so a native must not hold on to the span after it returns.
+struct ArgSpan {
+    const Obj* first = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Obj& operator[](size_t i) const { return first[i]; }
+    const Obj* begin() const { return first; }
+    const Obj* end() const { return first + count; }
+};
+
+// Native Function type definition (plain pointer, see native_bind.h)
+class Runtime;
+using NativeFn = Obj (*)(Runtime& rt, ArgSpan args);
+// Hidden class: maps field names to slots in LinkInstance::fields.
+// Instances that add the same fields in the same order share a shape, and
+// adding a field follows (or creates) a transition to a child shape.
+struct Shape {
+    std::unordered_map<Atom, int> slots;
+    std::unordered_map<Atom, std::shared_ptr<Shape>> transitions;
+
+    int lookup(Atom name) const {
+        auto it = slots.find(name);
+        return it == slots.end() ? -1 : it->second;
+    }
+    const std::shared_ptr<Shape>& withField(Atom name) {
+        auto& next = transitions[name];
+        if (!next) {
+            next = std::make_shared<Shape>();
+            next->slots = slots;
+            next->slots.emplace(name, (int)slots.size());
+        }
+        return next;
+    }
+};
+
 struct LinkClass {
     std::string name;
-    std::unordered_map<std::string, Stmt*> methods; 
+    std::unordered_map<Atom, Stmt*> methods; 
+    std::shared_ptr<Shape> rootShape = std::make_shared<Shape>();
 };
 struct LinkInstance {
     std::shared_ptr<LinkClass> klass;        
-    std::unordered_map<std::string, Value> fields;  
+    std::shared_ptr<Shape> shape;
+    std::vector<Value> fields;  
+    explicit LinkInstance(std::shared_ptr<LinkClass> k) : klass(std::move(k)), shape(klass->rootShape) {}
 };
 inline void printObj(const Obj& val) {
     if (std::holds_alternative<int>(val.as)) std::cout << std::get<int>(val.as);
     else if (std::holds_alternative<double>(val.as)) std::cout << std::get<double>(val.as);
-    else if (std::holds_alternative<std::string>(val.as)) std::cout << Sys::unescape(std::get<std::string>(val.as));
+    else if (val.isString()) std::cout << val.asLinkString().view();
     else if (std::holds_alternative<char>(val.as)) std::cout << std::get<char>(val.as);
     else if (std::holds_alternative<bool>(val.as)) std::cout << (std::get<bool>(val.as) ? "true" : "false");
     else if (std::holds_alternative<std::shared_ptr<List>>(val.as)) {
@@ -95,14 +233,14 @@ inline void printObj(const Obj& val) {
     else std::cout << "nil";
 }
 
-struct ReturnException {
-	Obj value; 
-	ReturnException(Obj v) : value(v) {}
+// Result of running a statement. return/break/continue are passed back
+// up through the block executors instead of being thrown.
+struct Completion {
+    enum Type { Normal, Return, Break, Continue };
+    Type type = Normal;
+    Obj value;
 };
 
-struct BreakException {}; 
-
-struct ContinueException {}; 
 struct RuntimeException {
     std::string message;
     RuntimeException(std::string msg) : message(msg) {}
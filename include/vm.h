@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.h"
+#include "compiler.h"
+#include "resolver.h"
+#include "runtime.h"
+
+// Stack-based bytecode engine, selected with --engine=vm.
+// Shares environments, natives and operator semantics with Runtime, so
+// statements the compiler cannot lower still run on the tree walker.
+class VM {
+public:
+    explicit VM(Runtime& runtime) : rt(runtime) {}
+
+    void execute(std::unique_ptr<Program> program, bool debugMode = false);
+
+private:
+    struct CallFrame {
+        Chunk* chunk;
+        size_t ip;
+        size_t base;
+        std::shared_ptr<Environment> callerEnv;
+        std::shared_ptr<LinkInstance> constructed; // Set for 'init' frames
+        bool discardResult;                         // Call used as a statement
+    };
+
+    Runtime& rt;
+    Compiler compiler;
+    std::vector<Obj> stack;
+    std::vector<CallFrame> frames;
+    std::unordered_map<const FuncDecl*, std::unique_ptr<Chunk>> functionChunks;
+    bool debug = false;
+
+    void run();
+    Chunk* chunkFor(FuncDecl* fn);
+    void callFunction(FuncDecl* fn, std::shared_ptr<Environment> env, size_t argc,
+                      bool discardResult, std::shared_ptr<LinkInstance> constructed = nullptr);
+    bool finishFrame(Obj result);
+};
@@ -0,0 +1,472 @@
+#include "compiler.h"
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+
+std::unique_ptr<Chunk> Compiler::compileProgram(const Program& program) {
+    auto result = std::make_unique<Chunk>();
+    chunk = result.get();
+    loops.clear();
+    nameSlots.clear();
+
+    block(program.statements);
+    emitOp(OpCode::NIL);
+    emitOp(OpCode::RETURN);
+    return result;
+}
+
+std::unique_ptr<Chunk> Compiler::compileFunction(const FuncDecl& fn) {
+    auto result = std::make_unique<Chunk>();
+    chunk = result.get();
+    loops.clear();
+    nameSlots.clear();
+
+    block(fn.body);
+    emitOp(OpCode::NIL); // Implicit 'return' at the end of the body
+    emitOp(OpCode::RETURN);
+    return result;
+}
+
+// ==========================================
+// EMIT HELPERS
+// ==========================================
+void Compiler::emitByte(uint8_t byte) { chunk->code.push_back(byte); }
+void Compiler::emitOp(OpCode op) { emitByte(static_cast<uint8_t>(op)); }
+
+void Compiler::emitShort(uint16_t value) {
+    emitByte((value >> 8) & 0xff);
+    emitByte(value & 0xff);
+}
+
+size_t Compiler::emitJump(OpCode op) {
+    emitOp(op);
+    emitShort(0xffff);
+    return chunk->code.size() - 2;
+}
+
+void Compiler::patchJump(size_t offset) {
+    size_t jump = chunk->code.size() - offset - 2;
+    if (jump > UINT16_MAX) throw std::runtime_error("VM: too much code to jump over");
+    chunk->code[offset] = (jump >> 8) & 0xff;
+    chunk->code[offset + 1] = jump & 0xff;
+}
+
+void Compiler::emitLoop(size_t target) {
+    emitOp(OpCode::LOOP);
+    size_t offset = chunk->code.size() - target + 2;
+    if (offset > UINT16_MAX) throw std::runtime_error("VM: loop body too large");
+    emitShort((uint16_t)offset);
+}
+
+uint16_t Compiler::makeConstant(const Obj& value) {
+    if (chunk->constants.size() >= UINT16_MAX) throw std::runtime_error("VM: too many constants in one chunk");
+    chunk->constants.push_back(value);
+    return (uint16_t)(chunk->constants.size() - 1);
+}
+
+uint16_t Compiler::identifier(Atom name) {
+    auto it = nameSlots.find(name);
+    if (it != nameSlots.end()) return it->second;
+    if (chunk->names.size() >= UINT16_MAX) throw std::runtime_error("VM: too many names in one chunk");
+    chunk->names.push_back(name);
+    uint16_t slot = (uint16_t)(chunk->names.size() - 1);
+    nameSlots[name] = slot;
+    return slot;
+}
+
+uint16_t Compiler::fieldCache(FieldCache* cache) {
+    if (chunk->fieldCaches.size() >= UINT16_MAX) throw std::runtime_error("VM: too many field accesses in one chunk");
+    chunk->fieldCaches.push_back(cache);
+    return (uint16_t)(chunk->fieldCaches.size() - 1);
+}
+
+// ==========================================
+// STATEMENTS
+// ==========================================
+void Compiler::block(const std::vector<Node<Stmt>>& stmts) {
+    for (auto& s : stmts) statement(s.get());
+}
+
+void Compiler::fallback(Stmt* stmt) {
+    if (chunk->fallbacks.size() >= UINT16_MAX) throw std::runtime_error("VM: too many statements in one chunk");
+    chunk->fallbacks.push_back(FallbackStmt{stmt});
+    uint16_t idx = (uint16_t)(chunk->fallbacks.size() - 1);
+    if (!loops.empty()) {
+        chunk->fallbacks[idx].continueTarget = (int)loops.back().continueTarget;
+        loops.back().fallbacks.push_back(idx);
+    }
+    emitOp(OpCode::EXEC_STMT);
+    emitShort(idx);
+}
+
+// Uses the Resolver's lexical address when there is one; the name operand
+// is kept for the runtime fallback when the slot is not bound yet.
+void Compiler::variable(OpCode byName, OpCode bySlot, Atom name, int depth, int slot) {
+    if (depth < 0 || depth > UINT8_MAX || slot > UINT16_MAX) {
+        emitOp(byName);
+        emitShort(identifier(name));
+        return;
+    }
+    emitOp(bySlot);
+    emitByte((uint8_t)depth);
+    emitShort((uint16_t)slot);
+    emitShort(identifier(name));
+}
+
+void Compiler::call(Atom func, const std::vector<Node<Expr>>& args, OpCode op,
+                    CallSite* site, MethodCache* cache) {
+    if (args.size() > UINT8_MAX) throw std::runtime_error("VM: too many arguments in call to " + func);
+    for (auto& arg : args) expression(arg.get());
+    emitOp(op);
+    emitShort(identifier(func));
+    if (site) {
+        if (chunk->callSites.size() >= UINT16_MAX) throw std::runtime_error("VM: too many calls in one chunk");
+        chunk->callSites.push_back(site);
+        emitShort((uint16_t)(chunk->callSites.size() - 1));
+    }
+    if (cache) {
+        if (chunk->methodCaches.size() >= UINT16_MAX) throw std::runtime_error("VM: too many method calls in one chunk");
+        chunk->methodCaches.push_back(cache);
+        emitShort((uint16_t)(chunk->methodCaches.size() - 1));
+    }
+    emitByte((uint8_t)args.size());
+}
+
+void Compiler::statement(Stmt* stmt) {
+    if (!stmt) return;
+
+    switch (stmt->kind) {
+    case StmtKind::Expr:
+        expression(static_cast<ExprStmt*>(stmt)->expression.get());
+        emitOp(OpCode::POP);
+        return;
+
+    case StmtKind::Set: {
+        auto set = static_cast<SetStmt*>(stmt);
+        if (set->append && set->depth >= 0 && set->depth <= UINT8_MAX && set->slot <= UINT16_MAX) {
+            expression(set->append->lhs.get());
+            expression(set->append->rhs.get());
+            variable(OpCode::SET_VAR, OpCode::APPEND_SLOT, set->name, set->depth, set->slot);
+            return;
+        }
+        expression(set->expression.get());
+        variable(OpCode::SET_VAR, OpCode::SET_SLOT, set->name, set->depth, set->slot);
+        return;
+    }
+
+    case StmtKind::SetIndex: {
+        auto setIdx = static_cast<SetIndexStmt*>(stmt);
+        expression(setIdx->list.get());
+        expression(setIdx->index.get());
+        expression(setIdx->value.get());
+        emitOp(OpCode::SET_INDEX);
+        return;
+    }
+
+    case StmtKind::Call: {
+        auto callStmt = static_cast<CallStmt*>(stmt);
+        call(callStmt->func, callStmt->args, OpCode::CALL_STMT, &callStmt->site);
+        return;
+    }
+
+    case StmtKind::If: {
+        auto ifStmt = static_cast<IfStmt*>(stmt);
+        expression(ifStmt->condition.get());
+        size_t elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+        block(ifStmt->thenBranch);
+        if (ifStmt->elseBranch.empty()) {
+            patchJump(elseJump);
+            return;
+        }
+        size_t endJump = emitJump(OpCode::JUMP);
+        patchJump(elseJump);
+        block(ifStmt->elseBranch);
+        patchJump(endJump);
+        return;
+    }
+
+    case StmtKind::While: {
+        auto whileLoop = static_cast<WhileStmt*>(stmt);
+        size_t loopStart = chunk->code.size();
+        loops.push_back(LoopContext{loopStart});
+
+        expression(whileLoop->condition.get());
+        size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+        block(whileLoop->body);
+        emitLoop(loopStart);
+        patchJump(exitJump);
+
+        for (size_t jump : loops.back().breakJumps) patchJump(jump);
+        for (size_t idx : loops.back().fallbacks) chunk->fallbacks[idx].breakTarget = (int)chunk->code.size();
+        loops.pop_back();
+        return;
+    }
+
+    case StmtKind::For: {
+        auto loop = static_cast<ForStmt*>(stmt);
+        uint16_t iter = identifier(loop->iteratorName);
+        // Iterator slot in the current frame, or 0xffff to go by name
+        uint16_t slot = (loop->slot >= 0 && loop->slot < 0xffff) ? (uint16_t)loop->slot : 0xffff;
+
+        // Stack while looping: [list, index]
+        expression(loop->collection.get());
+        emitOp(OpCode::FOR_PREP);
+        emitShort(iter);
+        emitShort(slot);
+        emitShort(0xffff);
+        size_t skipJump = chunk->code.size() - 2;
+
+        size_t loopStart = chunk->code.size();
+        loops.push_back(LoopContext{loopStart});
+        emitOp(OpCode::FOR_NEXT);
+        emitShort(iter);
+        emitShort(slot);
+        emitShort(0xffff);
+        size_t exitJump = chunk->code.size() - 2;
+
+        block(loop->body);
+        emitLoop(loopStart);
+
+        // Loop exhausted or 'break': drop the iterator state
+        patchJump(exitJump);
+        for (size_t jump : loops.back().breakJumps) patchJump(jump);
+        for (size_t idx : loops.back().fallbacks) chunk->fallbacks[idx].breakTarget = (int)chunk->code.size();
+        loops.pop_back();
+        emitOp(OpCode::POP);
+        emitOp(OpCode::POP);
+        patchJump(skipJump);
+        return;
+    }
+
+    case StmtKind::Return: {
+        auto ret = static_cast<ReturnStmt*>(stmt);
+        if (ret->value) expression(ret->value.get());
+        else emitOp(OpCode::NIL);
+        emitOp(OpCode::RETURN);
+        return;
+    }
+
+    case StmtKind::Break:
+        if (loops.empty()) { fallback(stmt); return; }
+        loops.back().breakJumps.push_back(emitJump(OpCode::JUMP));
+        return;
+
+    case StmtKind::Continue:
+        if (loops.empty()) { fallback(stmt); return; }
+        emitLoop(loops.back().continueTarget);
+        return;
+
+    case StmtKind::Func: {
+        if (chunk->functions.size() >= UINT16_MAX) throw std::runtime_error("VM: too many functions in one chunk");
+        chunk->functions.push_back(static_cast<FuncDecl*>(stmt));
+        emitOp(OpCode::CLOSURE);
+        emitShort((uint16_t)(chunk->functions.size() - 1));
+        return;
+    }
+
+    // Classes, try/catch, import, extern and shell statements run on the tree walker
+    default:
+        fallback(stmt);
+        return;
+    }
+}
+
+// ==========================================
+// EXPRESSIONS
+// ==========================================
+void Compiler::expression(Expr* expr) {
+    if (!expr) { emitOp(OpCode::NIL); return; }
+
+    switch (expr->kind) {
+    case ExprKind::Number:
+        emitOp(OpCode::CONSTANT);
+        emitShort(makeConstant(Obj(static_cast<NumberExpr*>(expr)->value)));
+        return;
+    case ExprKind::Float:
+        emitOp(OpCode::CONSTANT);
+        emitShort(makeConstant(Obj(static_cast<FloatExpr*>(expr)->value)));
+        return;
+    case ExprKind::String:
+        emitOp(OpCode::CONSTANT);
+        emitShort(makeConstant(Obj(static_cast<StringExpr*>(expr)->value)));
+        return;
+    case ExprKind::Char:
+        emitOp(OpCode::CONSTANT);
+        emitShort(makeConstant(Obj(static_cast<CharExpr*>(expr)->value)));
+        return;
+    case ExprKind::Bool:
+        emitOp(static_cast<BoolExpr*>(expr)->value ? OpCode::TRUE : OpCode::FALSE);
+        return;
+
+    case ExprKind::Variable: {
+        auto var = static_cast<VariableExpr*>(expr);
+        variable(OpCode::GET_VAR, OpCode::GET_SLOT, var->name, var->depth, var->slot);
+        return;
+    }
+    case ExprKind::This: {
+        auto self = static_cast<ThisExpr*>(expr);
+        variable(OpCode::GET_VAR, OpCode::GET_SLOT, atoms::self, self->depth, self->slot);
+        return;
+    }
+
+    case ExprKind::Array: {
+        auto arr = static_cast<ArrayExpr*>(expr);
+        if (arr->elements.size() > UINT16_MAX) throw std::runtime_error("VM: list literal too large");
+        for (auto& el : arr->elements) expression(el.get());
+        emitOp(OpCode::MAKE_LIST);
+        emitShort((uint16_t)arr->elements.size());
+        return;
+    }
+    case ExprKind::Dict: {
+        auto dictNode = static_cast<DictExpr*>(expr);
+        if (dictNode->pairs.size() > UINT16_MAX) throw std::runtime_error("VM: dict literal too large");
+        for (auto& p : dictNode->pairs) {
+            expression(p.first.get());
+            expression(p.second.get());
+        }
+        emitOp(OpCode::MAKE_DICT);
+        emitShort((uint16_t)dictNode->pairs.size());
+        return;
+    }
+    case ExprKind::Index: {
+        auto idx = static_cast<IndexExpr*>(expr);
+        expression(idx->object.get());
+        expression(idx->index.get());
+        emitOp(OpCode::GET_INDEX);
+        return;
+    }
+
+    case ExprKind::Get: {
+        auto get = static_cast<GetExpr*>(expr);
+        expression(get->object.get());
+        emitOp(OpCode::GET_FIELD);
+        emitShort(identifier(get->name));
+        emitShort(fieldCache(&get->cache));
+        return;
+    }
+    case ExprKind::Set: {
+        auto set = static_cast<SetExpr*>(expr);
+        expression(set->object.get());
+        expression(set->value.get());
+        emitOp(OpCode::SET_FIELD);
+        emitShort(identifier(set->name));
+        emitShort(fieldCache(&set->cache));
+        return;
+    }
+
+    case ExprKind::MethodCall: {
+        auto methodCall = static_cast<MethodCallExpr*>(expr);
+        expression(methodCall->object.get());
+        call(methodCall->method, methodCall->args, OpCode::INVOKE, nullptr, &methodCall->cache);
+        return;
+    }
+    case ExprKind::New: {
+        auto newExpr = static_cast<NewExpr*>(expr);
+        call(newExpr->className, newExpr->args, OpCode::NEW, nullptr, &newExpr->initCache);
+        return;
+    }
+    case ExprKind::Call: {
+        auto callExpr = static_cast<CallExpr*>(expr);
+        call(callExpr->func, callExpr->args, OpCode::CALL, &callExpr->site);
+        return;
+    }
+
+    case ExprKind::Binary: {
+        auto bin = static_cast<BinaryExpr*>(expr);
+        expression(bin->lhs.get());
+        expression(bin->rhs.get());
+        emitOp(OpCode::BINARY);
+        emitByte((uint8_t)bin->op);
+        return;
+    }
+
+    case ExprKind::Negate:
+        expression(static_cast<NegateExpr*>(expr)->operand.get());
+        emitOp(OpCode::NEGATE);
+        return;
+    }
+}
+
+// ==========================================
+// DISASSEMBLER (--debug with --engine=vm)
+// ==========================================
+static const char* opName(OpCode op) {
+    switch (op) {
+        case OpCode::CONSTANT: return "CONSTANT";
+        case OpCode::NIL: return "NIL";
+        case OpCode::TRUE: return "TRUE";
+        case OpCode::FALSE: return "FALSE";
+        case OpCode::POP: return "POP";
+        case OpCode::GET_VAR: return "GET_VAR";
+        case OpCode::SET_VAR: return "SET_VAR";
+        case OpCode::GET_SLOT: return "GET_SLOT";
+        case OpCode::SET_SLOT: return "SET_SLOT";
+        case OpCode::APPEND_SLOT: return "APPEND_SLOT";
+        case OpCode::BINARY: return "BINARY";
+        case OpCode::NEGATE: return "NEGATE";
+        case OpCode::MAKE_LIST: return "MAKE_LIST";
+        case OpCode::MAKE_DICT: return "MAKE_DICT";
+        case OpCode::GET_INDEX: return "GET_INDEX";
+        case OpCode::SET_INDEX: return "SET_INDEX";
+        case OpCode::GET_FIELD: return "GET_FIELD";
+        case OpCode::SET_FIELD: return "SET_FIELD";
+        case OpCode::CALL: return "CALL";
+        case OpCode::CALL_STMT: return "CALL_STMT";
+        case OpCode::INVOKE: return "INVOKE";
+        case OpCode::NEW: return "NEW";
+        case OpCode::JUMP: return "JUMP";
+        case OpCode::JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case OpCode::LOOP: return "LOOP";
+        case OpCode::FOR_PREP: return "FOR_PREP";
+        case OpCode::FOR_NEXT: return "FOR_NEXT";
+        case OpCode::CLOSURE: return "CLOSURE";
+        case OpCode::EXEC_STMT: return "EXEC_STMT";
+        case OpCode::RETURN: return "RETURN";
+    }
+    return "?";
+}
+
+void disassembleChunk(const Chunk& chunk, const std::string& title) {
+    std::cout << "== " << title << " ==\n";
+    const auto& code = chunk.code;
+    auto u16 = [&](size_t at) { return (uint16_t)((code[at] << 8) | code[at + 1]); };
+
+    size_t ip = 0;
+    while (ip < code.size()) {
+        OpCode op = static_cast<OpCode>(code[ip]);
+        std::cout << std::setw(5) << std::setfill('0') << ip << std::setfill(' ') << "  " << opName(op);
+        switch (op) {
+            case OpCode::CONSTANT:
+                std::cout << " #" << u16(ip + 1); ip += 3; break;
+            case OpCode::GET_VAR: case OpCode::SET_VAR:
+                std::cout << " " << chunk.names[u16(ip + 1)]; ip += 3; break;
+            case OpCode::GET_FIELD: case OpCode::SET_FIELD:
+                std::cout << " " << chunk.names[u16(ip + 1)]; ip += 5; break;
+            case OpCode::GET_SLOT: case OpCode::SET_SLOT: case OpCode::APPEND_SLOT:
+                std::cout << " " << chunk.names[u16(ip + 4)] << " @" << (int)code[ip + 1] << ":" << u16(ip + 2);
+                ip += 6; break;
+            case OpCode::BINARY:
+                std::cout << " '" << (char)code[ip + 1] << "'"; ip += 2; break;
+            case OpCode::MAKE_LIST: case OpCode::MAKE_DICT:
+                std::cout << " " << u16(ip + 1); ip += 3; break;
+            case OpCode::CALL: case OpCode::CALL_STMT:
+            case OpCode::INVOKE: case OpCode::NEW:
+                std::cout << " " << chunk.names[u16(ip + 1)] << " argc=" << (int)code[ip + 5]; ip += 6; break;
+            case OpCode::JUMP: case OpCode::JUMP_IF_FALSE:
+                std::cout << " -> " << ip + 3 + u16(ip + 1); ip += 3; break;
+            case OpCode::LOOP:
+                std::cout << " -> " << ip + 3 - u16(ip + 1); ip += 3; break;
+            case OpCode::FOR_PREP: case OpCode::FOR_NEXT:
+                std::cout << " " << chunk.names[u16(ip + 1)];
+                if (u16(ip + 3) != 0xffff) std::cout << " @0:" << u16(ip + 3);
+                std::cout << " -> " << ip + 7 + u16(ip + 5); ip += 7; break;
+            case OpCode::CLOSURE:
+                std::cout << " " << chunk.functions[u16(ip + 1)]->name; ip += 3; break;
+            case OpCode::EXEC_STMT:
+                std::cout << " #" << u16(ip + 1); ip += 3; break;
+            default:
+                ip += 1; break;
+        }
+        std::cout << "\n";
+    }
+}
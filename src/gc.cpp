@@ -0,0 +1,152 @@
+#include "gc.h"
+#include "env.h"
+#include <algorithm>
+#include <unordered_map>
+
+Collector& Collector::instance() {
+    static Collector collector;
+    return collector;
+}
+
+// Calls visit(kind, child, useCount) for every strong reference the object
+// holds to another collectable object. Environments and cells are not
+// registered, but are traced through: a cycle through either always passes
+// through the LinkFunction that captured it.
+template <typename Visit>
+void Collector::forEachChild(Kind kind, void* object, Visit&& visit) {
+    auto value = [&](const Value& v) {
+        if (v.isList()) visit(Kind::List, v.asList().get(), v.asList().use_count());
+        else if (v.isDict()) visit(Kind::Dict, v.asDict().get(), v.asDict().use_count());
+        else if (v.isInstance()) visit(Kind::Instance, v.asInstance().get(), v.asInstance().use_count());
+        else if (v.isFunction()) visit(Kind::Function, v.asFunction().get(), v.asFunction().use_count());
+    };
+    auto env = [&](const std::shared_ptr<Environment>& e) {
+        if (e) visit(Kind::Env, e.get(), e.use_count());
+    };
+
+    switch (kind) {
+    case Kind::List:
+        for (const Value& v : *static_cast<List*>(object)) value(v);
+        break;
+    case Kind::Dict:
+        for (const auto& entry : *static_cast<Dict*>(object)) value(entry.second);
+        break;
+    case Kind::Instance:
+        for (const Value& v : static_cast<LinkInstance*>(object)->fields) value(v);
+        break;
+    case Kind::Function: {
+        auto function = static_cast<LinkFunction*>(object);
+        env(function->closure);
+        for (const auto& cell : function->upvalues) visit(Kind::Cell, cell.get(), cell.use_count());
+        break;
+    }
+    case Kind::Env: {
+        auto frame = static_cast<Environment*>(object);
+        env(frame->enclosing);
+        for (const auto& slot : frame->slots) {
+            if (slot.cell) visit(Kind::Cell, slot.cell.get(), slot.cell.use_count());
+            else value(slot.value);
+        }
+        break;
+    }
+    case Kind::Cell:
+        value(static_cast<Cell*>(object)->value);
+        break;
+    }
+}
+
+void Collector::prune() {
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const Entry& entry) { return entry.ref.expired(); }),
+                  entries.end());
+}
+
+// Trial deletion: count the references each object receives from inside
+// the traced heap. Objects with more references than that are held from
+// outside (an environment root, the VM stack, a native's locals) and are
+// marked live together with everything they reach. What is left is only
+// referenced by itself, so clearing its contents lets the refcounts free it.
+size_t Collector::collect() {
+    prune();
+
+    struct Node {
+        Kind kind;
+        long refs;
+        long internal = 0;
+        bool reachable = false;
+    };
+    std::unordered_map<void*, Node> nodes;
+    nodes.reserve(entries.size() * 2);
+    std::vector<void*> work;
+    for (auto& entry : entries) {
+        if (nodes.try_emplace(entry.object, Node{entry.kind, entry.ref.use_count()}).second) {
+            work.push_back(entry.object);
+        }
+    }
+
+    for (size_t i = 0; i < work.size(); i++) {
+        forEachChild(nodes.at(work[i]).kind, work[i], [&](Kind kind, void* child, long uses) {
+            auto [it, added] = nodes.try_emplace(child, Node{kind, uses});
+            it->second.internal++;
+            if (added) work.push_back(child);
+        });
+    }
+
+    work.clear();
+    for (auto& [object, node] : nodes) {
+        if (node.refs > node.internal) {
+            node.reachable = true;
+            work.push_back(object);
+        }
+    }
+    while (!work.empty()) {
+        void* object = work.back();
+        work.pop_back();
+        forEachChild(nodes.at(object).kind, object, [&](Kind, void* child, long) {
+            Node& node = nodes.at(child);
+            if (!node.reachable) {
+                node.reachable = true;
+                work.push_back(child);
+            }
+        });
+    }
+
+    // Hold every garbage object while the cycles are cut, so none is
+    // destroyed halfway through
+    std::vector<std::pair<Kind, std::shared_ptr<void>>> garbage;
+    for (auto& entry : entries) {
+        if (!nodes.at(entry.object).reachable) garbage.emplace_back(entry.kind, entry.ref.lock());
+    }
+    for (auto& [kind, object] : garbage) {
+        switch (kind) {
+        case Kind::List: static_cast<List*>(object.get())->clear(); break;
+        case Kind::Dict: static_cast<Dict*>(object.get())->clear(); break;
+        case Kind::Instance: static_cast<LinkInstance*>(object.get())->fields.clear(); break;
+        case Kind::Function: {
+            auto function = static_cast<LinkFunction*>(object.get());
+            function->closure.reset();
+            function->upvalues.clear();
+            break;
+        }
+        case Kind::Env:
+        case Kind::Cell:
+            break;
+        }
+    }
+    size_t freed = garbage.size();
+    garbage.clear();
+
+    prune();
+    totals.collections++;
+    totals.freed += freed;
+    totals.lastFreed = freed;
+    sinceCollect = 0;
+    threshold = std::max(MIN_THRESHOLD, entries.size());
+    return freed;
+}
+
+Collector::Stats Collector::stats() {
+    prune();
+    totals.tracked = entries.size();
+    return totals;
+}
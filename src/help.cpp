@@ -19,6 +19,9 @@ USAGE:
   ./link                  : Enter Interactive Mode (REPL).
   ./link <file.link>      : Execute a Link-Lang script file.
   ./link --debug <file>   : Execute with AST Debug Mode.
+  ./link --engine=vm <file> : Execute on the bytecode VM (default: tree).
+  ./link --unbuffered <file> : Write output immediately (no stdout buffering).
+  ./link --dump-opt <file> : Print the AST after constant folding.
   ./link --help           : Show this manual.
   ./link --version        : Show current version.
 
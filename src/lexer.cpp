@@ -1,9 +1,19 @@
 #include "lexer.h"
+#include "os.h"
 #include <cctype>
 #include <stdexcept>
-#include <unordered_map>
 
-static const std::unordered_map<std::string, TokenType> keywords = {
+// Keyword lookup by perfect hash: length, first and last character pick a
+// distinct slot for every keyword, and one comparison confirms the match.
+// The constants were searched for this keyword set; keywordTable() fails
+// to compile if an edit to the list introduces a collision.
+namespace {
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr Keyword keywords[] = {
     {"app", TokenType::APP},            {"for", TokenType::FOR},            {"while", TokenType::WHILE},
     {"if", TokenType::IF},              {"elif", TokenType::ELIF},          {"else", TokenType::ELSE},
     {"window", TokenType::WINDOW},      {"func", TokenType::FUNC},          {"return", TokenType::RETURN},  
@@ -20,6 +30,34 @@ static const std::unordered_map<std::string, TokenType> keywords = {
     {"clear", TokenType::CLEAR},        {"cls", TokenType::CLS} 
 };
 
+constexpr size_t KEYWORD_SLOTS = 64;
+
+constexpr size_t keywordSlot(std::string_view s) {
+    return (s.size() * 7 + (unsigned char)s.front() * 16 + (unsigned char)s.back() * 12) & (KEYWORD_SLOTS - 1);
+}
+
+struct KeywordTable {
+    Keyword slots[KEYWORD_SLOTS] = {};
+};
+
+constexpr KeywordTable keywordTable() {
+    KeywordTable table;
+    for (const Keyword& kw : keywords) {
+        Keyword& slot = table.slots[keywordSlot(kw.text)];
+        if (!slot.text.empty()) throw "keyword hash collision"; // Not a constant expression
+        slot = kw;
+    }
+    return table;
+}
+
+constexpr KeywordTable keywordSlots = keywordTable();
+
+TokenType keywordType(std::string_view word) {
+    const Keyword& kw = keywordSlots.slots[keywordSlot(word)];
+    return kw.text == word ? kw.type : TokenType::IDENTIFIER;
+}
+}
+
 Lexer::Lexer(const std::string& source) : src(source), pos(0), line(1), column(1) {
     indentStack.push_back(0);
 }
@@ -41,7 +79,7 @@ bool Lexer::match(char expected) {
     return true;
 }
 
-Token Lexer::makeToken(TokenType type, const std::string& value) {
+Token Lexer::makeToken(TokenType type, std::string_view value) {
     return Token{type, value, line, column};
 }
 
@@ -53,38 +91,52 @@ void Lexer::skipWhitespace() {
 
 Token Lexer::identifier() {
     int startCol = column;
-    std::string value;
-    while (std::isalnum(peek()) || peek() == '_') value += advance();
-    auto it = keywords.find(value);
-    if (it != keywords.end()) return Token{it->second, value, line, startCol};
-    return Token{TokenType::IDENTIFIER, value, line, startCol};
+    size_t start = pos;
+    while (std::isalnum(peek()) || peek() == '_') advance();
+    std::string_view value = text(start);
+    return Token{keywordType(value), value, line, startCol};
 }
 
-Token Lexer::stringLiteral() {
+// Escapes are decoded here, once, so the runtime only ever sees the final
+// text. Only literals that contain one get owned storage; the rest stay
+// views into the source. Extern headers pass decode=false to hand their
+// flags to the compiler verbatim.
+Token Lexer::stringLiteral(bool decode) {
     int startCol = column;
-    std::string value;
     advance(); 
+    size_t start = pos;
+    bool escaped = false;
     while (peek() != '"' && peek() != '\0') {
         if (peek() == '\n') throw std::runtime_error("Unterminated string");
-        value += advance();
+        char c = advance();
+        if (c == '\\' && peek() != '\0' && peek() != '\n') { // Keeps \" inside the literal
+            advance();
+            escaped = true;
+        }
     }
+    std::string_view value = text(start);
     if (!match('"')) throw std::runtime_error("Unterminated string");
+    if (decode && escaped) {
+        if (decoded.size() == DECODED_KEEP) decoded.pop_front();
+        decoded.push_back(Sys::unescape(std::string(value)));
+        value = decoded.back();
+    }
     return Token{TokenType::STRING, value, line, startCol};
 }
 
-void Lexer::handleIndentation(std::vector<Token>& tokens) {
+void Lexer::handleIndentation() {
     int count = 0;
     while (peek() == ' ') { advance(); count++; }
     if (peek() == '\n' || peek() == '\0') return;
     int currentIndent = indentStack.back();
     if (count > currentIndent) {
         indentStack.push_back(count);
-        tokens.push_back(makeToken(TokenType::INDENT));
+        pending.push_back(makeToken(TokenType::INDENT));
     } else {
         while (count < currentIndent) {
             indentStack.pop_back();
             currentIndent = indentStack.back();
-            tokens.push_back(makeToken(TokenType::DEDENT));
+            pending.push_back(makeToken(TokenType::DEDENT));
         }
         if (count != currentIndent) throw std::runtime_error("Invalid indentation");
     }
@@ -96,45 +148,57 @@ void Lexer::skipComment() {
 
 Token Lexer::number() {
     int startCol = column;
-    std::string value;
+    size_t start = pos;
     bool isFloat = false;
-    while (std::isdigit(peek())) value += advance();
+    while (std::isdigit(peek())) advance();
     if (peek() == '.') {
-        isFloat = true; value += advance();
-        while (std::isdigit(peek())) value += advance();
+        isFloat = true; advance();
+        while (std::isdigit(peek())) advance();
     }
-    return Token{isFloat ? TokenType::TOKEN_FLOAT : TokenType::TOKEN_NUM, value, line, startCol}; 
+    return Token{isFloat ? TokenType::TOKEN_FLOAT : TokenType::TOKEN_NUM, text(start), line, startCol}; 
+}
+
+Token Lexer::next() {
+    if (pending.empty()) scan();
+    Token token = pending.front();
+    if (token.type != TokenType::EOF_TOKEN) pending.pop_front();
+    return token;
 }
 
-std::vector<Token> Lexer::tokenize() {
-    std::vector<Token> tokens;
-    while (pos < src.size()) {
+// Scans until at least one token is pending. One step can yield several
+// tokens: a newline with its INDENT/DEDENTs, or a whole extern block.
+void Lexer::scan() {
+    while (pending.empty()) {
+        if (pos >= src.size()) {
+            pending.push_back(makeToken(TokenType::EOF_TOKEN));
+            return;
+        }
         char c = peek();
         
         // Exception so #include and #define pass through for extern C++
         if (c == '#') { 
             if (src.substr(pos, 8) == "#include" || src.substr(pos, 7) == "#define") {
                 int startCol = column;
-                std::string val;
-                while(peek() != '\n' && peek() != '\0') val += advance();
-                tokens.push_back(Token{TokenType::IDENTIFIER, val, line, startCol});
+                size_t start = pos;
+                while(peek() != '\n' && peek() != '\0') advance();
+                pending.push_back(Token{TokenType::IDENTIFIER, text(start), line, startCol});
                 continue;
             }
             skipComment(); 
             continue; 
         }
         
-        if (c == '\n') { advance(); tokens.push_back(makeToken(TokenType::NEWLINE)); line++; column = 1; handleIndentation(tokens); continue; }
+        if (c == '\n') { advance(); pending.push_back(makeToken(TokenType::NEWLINE)); line++; column = 1; handleIndentation(); continue; }
         if (c == ' ' || c == '\t') { skipWhitespace(); continue; }
         if (std::isalpha(c) || c == '_') { 
             Token idToken = identifier();
-            tokens.push_back(idToken); 
+            pending.push_back(idToken); 
             
             // --- RAW BLOCK CATCHER FOR EXTERN ---
             if (idToken.type == TokenType::EXTERN) {
                 skipWhitespace();
                 if (peek() == '"') {
-                    tokens.push_back(stringLiteral()); // 1. Tangkap Bahasa (misal: "c")
+                    pending.push_back(stringLiteral(false)); // 1. Tangkap Bahasa (misal: "c")
                     
                     // Lambda helper to skip spaces and newlines without creating a NEWLINE token
                     auto skipSpaceAndNewlines = [&]() {
@@ -148,16 +212,16 @@ std::vector<Token> Lexer::tokenize() {
                     
                     // 2. Check if there is a second string (Optional flags, e.g. "-O3 -lraylib")
                     if (peek() == '"') {
-                        tokens.push_back(stringLiteral());
+                        pending.push_back(stringLiteral(false));
                         skipSpaceAndNewlines();
                     }
                     
                     // 3. Start capturing raw C++ code
                     if (peek() == '{') {
                         advance(); // Makan '{'
-                        tokens.push_back(makeToken(TokenType::LBRACE, "{"));
+                        pending.push_back(makeToken(TokenType::LBRACE, "{"));
                         
-                        std::string rawCode = "";
+                        size_t rawStart = pos;
                         int braceCount = 1;
                         
                         // Loop penangkap teks murni (Mengabaikan aturan token Link-Lang)
@@ -166,12 +230,12 @@ std::vector<Token> Lexer::tokenize() {
                             
                             // Abaikan kurung kurawal di dalam string C++ (misal: print("{"))
                             if (nextChar == '"') {
-                                rawCode += advance();
+                                advance();
                                 while(peek() != '"' && pos < src.size()) {
-                                    if (peek() == '\\') rawCode += advance();
-                                    rawCode += advance();
+                                    if (peek() == '\\') advance();
+                                    advance();
                                 }
-                                if (peek() == '"') rawCode += advance();
+                                if (peek() == '"') advance();
                                 continue;
                             }
                             
@@ -182,113 +246,111 @@ std::vector<Token> Lexer::tokenize() {
                             }
                             
                             if (nextChar == '\n') { line++; column = 1; }
-                            rawCode += advance();
+                            advance();
                         }
                         
                         // Masukkan seluruh kode C++ sebagai 1 token string raksasa
-                        tokens.push_back(makeToken(TokenType::STRING, rawCode));
+                        pending.push_back(makeToken(TokenType::STRING, text(rawStart)));
                         
                         if (peek() == '}') {
                             advance(); // Makan '}'
-                            tokens.push_back(makeToken(TokenType::RBRACE, "}"));
+                            pending.push_back(makeToken(TokenType::RBRACE, "}"));
                         }
                     }
                 }
             }
             continue; 
         }
-        if (std::isdigit(c)) { tokens.push_back(number()); continue; }
-        if (c == '"') { tokens.push_back(stringLiteral()); continue; }
+        if (std::isdigit(c)) { pending.push_back(number()); continue; }
+        if (c == '"') { pending.push_back(stringLiteral()); continue; }
         if (c == '\'') { /* Existing single-quote char logic... */ }
 
         // --- ADDITIONAL LEGAL C++ SYMBOLS TO AVOID UNKNOWN CHAR ---
-        if (c == ';') { advance(); tokens.push_back(makeToken(TokenType::SEMICOLON, ";")); continue; }
-        if (c == '%') { advance(); tokens.push_back(makeToken(TokenType::IDENTIFIER, "%")); continue; }
-        if (c == '~') { advance(); tokens.push_back(makeToken(TokenType::IDENTIFIER, "~")); continue; }
-        if (c == '?') { advance(); tokens.push_back(makeToken(TokenType::IDENTIFIER, "?")); continue; }
-        if (c == '\\') { advance(); tokens.push_back(makeToken(TokenType::IDENTIFIER, "\\")); continue; }
-        if (c == '$') { advance(); tokens.push_back(makeToken(TokenType::IDENTIFIER, "$")); continue; }
+        if (c == ';') { advance(); pending.push_back(makeToken(TokenType::SEMICOLON, ";")); continue; }
+        if (c == '%') { advance(); pending.push_back(makeToken(TokenType::IDENTIFIER, "%")); continue; }
+        if (c == '~') { advance(); pending.push_back(makeToken(TokenType::IDENTIFIER, "~")); continue; }
+        if (c == '?') { advance(); pending.push_back(makeToken(TokenType::IDENTIFIER, "?")); continue; }
+        if (c == '\\') { advance(); pending.push_back(makeToken(TokenType::IDENTIFIER, "\\")); continue; }
+        if (c == '$') { advance(); pending.push_back(makeToken(TokenType::IDENTIFIER, "$")); continue; }
         // ---------------------------------------------------------
         
         if (c == '!') {
             advance();
-            if (match('=')) tokens.push_back(makeToken(TokenType::BANG_EQ, "!="));
-            else tokens.push_back(makeToken(TokenType::BANG, "!"));
+            if (match('=')) pending.push_back(makeToken(TokenType::BANG_EQ, "!="));
+            else pending.push_back(makeToken(TokenType::BANG, "!"));
             continue;
         }
         
-        if (c == '(') { advance(); tokens.push_back(makeToken(TokenType::LPAREN, "(")); continue; }
-        if (c == ')') { advance(); tokens.push_back(makeToken(TokenType::RPAREN, ")")); continue; }
-        if (c == '[') { advance(); tokens.push_back(makeToken(TokenType::LBRACKET, "[")); continue; }
-        if (c == ']') { advance(); tokens.push_back(makeToken(TokenType::RBRACKET, "]")); continue; }
-        if (c == '{') { advance(); tokens.push_back(makeToken(TokenType::LBRACE, "{")); continue; }
-        if (c == '}') { advance(); tokens.push_back(makeToken(TokenType::RBRACE, "}")); continue; }
-        if (c == '.') { advance(); tokens.push_back(makeToken(TokenType::DOT, ".")); continue; }
-        if (c == ',') { advance(); tokens.push_back(makeToken(TokenType::COMMA, ",")); continue; }
-        if (c == ':') { advance(); tokens.push_back(makeToken(TokenType::COLON, ":")); continue; }
+        if (c == '(') { advance(); pending.push_back(makeToken(TokenType::LPAREN, "(")); continue; }
+        if (c == ')') { advance(); pending.push_back(makeToken(TokenType::RPAREN, ")")); continue; }
+        if (c == '[') { advance(); pending.push_back(makeToken(TokenType::LBRACKET, "[")); continue; }
+        if (c == ']') { advance(); pending.push_back(makeToken(TokenType::RBRACKET, "]")); continue; }
+        if (c == '{') { advance(); pending.push_back(makeToken(TokenType::LBRACE, "{")); continue; }
+        if (c == '}') { advance(); pending.push_back(makeToken(TokenType::RBRACE, "}")); continue; }
+        if (c == '.') { advance(); pending.push_back(makeToken(TokenType::DOT, ".")); continue; }
+        if (c == ',') { advance(); pending.push_back(makeToken(TokenType::COMMA, ",")); continue; }
+        if (c == ':') { advance(); pending.push_back(makeToken(TokenType::COLON, ":")); continue; }
 
-        if (c == '*') { advance(); tokens.push_back(makeToken(TokenType::STAR, "*")); continue; }
-        if (c == '/') { advance(); tokens.push_back(makeToken(TokenType::SLASH, "/")); continue; }
+        if (c == '*') { advance(); pending.push_back(makeToken(TokenType::STAR, "*")); continue; }
+        if (c == '/') { advance(); pending.push_back(makeToken(TokenType::SLASH, "/")); continue; }
         
-        if (c == '&') { advance(); tokens.push_back(makeToken(TokenType::BIT_AND, "&")); continue; }
-        if (c == '|') { advance(); tokens.push_back(makeToken(TokenType::BIT_OR, "|")); continue; }
-        if (c == '^') { advance(); tokens.push_back(makeToken(TokenType::XOR, "^")); continue; }
+        if (c == '&') { advance(); pending.push_back(makeToken(TokenType::BIT_AND, "&")); continue; }
+        if (c == '|') { advance(); pending.push_back(makeToken(TokenType::BIT_OR, "|")); continue; }
+        if (c == '^') { advance(); pending.push_back(makeToken(TokenType::XOR, "^")); continue; }
         
         if (c == '<') {
             advance();
-            if (match('<')) tokens.push_back(makeToken(TokenType::LSHIFT, "<<"));
-            else if (match('=')) tokens.push_back(makeToken(TokenType::LT, "<=")); // If you implement LE later
-            else tokens.push_back(makeToken(TokenType::LT, "<"));
+            if (match('<')) pending.push_back(makeToken(TokenType::LSHIFT, "<<"));
+            else if (match('=')) pending.push_back(makeToken(TokenType::LT, "<=")); // If you implement LE later
+            else pending.push_back(makeToken(TokenType::LT, "<"));
             continue;
         }
         
         if (c == '>') {
             advance();
-            if (match('>')) tokens.push_back(makeToken(TokenType::RSHIFT, ">>"));
-            else if (match('=')) tokens.push_back(makeToken(TokenType::GT, ">=")); // If you implement GE later
-            else tokens.push_back(makeToken(TokenType::GT, ">"));
+            if (match('>')) pending.push_back(makeToken(TokenType::RSHIFT, ">>"));
+            else if (match('=')) pending.push_back(makeToken(TokenType::GT, ">=")); // If you implement GE later
+            else pending.push_back(makeToken(TokenType::GT, ">"));
             continue;
         }
         
         if (c == '=') { 
             advance(); 
-            if (match('=')) tokens.push_back(makeToken(TokenType::EQ_EQ, "=="));
-            else tokens.push_back(makeToken(TokenType::ASSIGN, "=")); 
+            if (match('=')) pending.push_back(makeToken(TokenType::EQ_EQ, "=="));
+            else pending.push_back(makeToken(TokenType::ASSIGN, "=")); 
             continue; 
         }
         
         if (c == '+') {
             advance();
-            if (match('+')) tokens.push_back(makeToken(TokenType::PLUS_PLUS, "++"));
-            else if (match('=')) tokens.push_back(makeToken(TokenType::PLUS_EQ, "+=")); 
-            else tokens.push_back(makeToken(TokenType::PLUS, "+")); 
+            if (match('+')) pending.push_back(makeToken(TokenType::PLUS_PLUS, "++"));
+            else if (match('=')) pending.push_back(makeToken(TokenType::PLUS_EQ, "+=")); 
+            else pending.push_back(makeToken(TokenType::PLUS, "+")); 
             continue;
         }
         
         if (c == '-') {
             advance();
-            if (match('>')) tokens.push_back(makeToken(TokenType::ARROW, "->"));
-            else if (match('=')) tokens.push_back(makeToken(TokenType::MINUS_EQ, "-=")); 
-            else tokens.push_back(makeToken(TokenType::MINUS, "-")); 
+            if (match('>')) pending.push_back(makeToken(TokenType::ARROW, "->"));
+            else if (match('=')) pending.push_back(makeToken(TokenType::MINUS_EQ, "-=")); 
+            else pending.push_back(makeToken(TokenType::MINUS, "-")); 
             continue;
         }
         
         if (c == '*') { 
             advance(); 
-            if (match('=')) tokens.push_back(makeToken(TokenType::STAR_EQ, "*="));
-            else tokens.push_back(makeToken(TokenType::STAR, "*")); 
+            if (match('=')) pending.push_back(makeToken(TokenType::STAR_EQ, "*="));
+            else pending.push_back(makeToken(TokenType::STAR, "*")); 
             continue;
         }
         
         if (c == '/') { 
             advance(); 
-            if (match('=')) tokens.push_back(makeToken(TokenType::SLASH_EQ, "/=")); 
-            else tokens.push_back(makeToken(TokenType::SLASH, "/")); 
+            if (match('=')) pending.push_back(makeToken(TokenType::SLASH_EQ, "/=")); 
+            else pending.push_back(makeToken(TokenType::SLASH, "/")); 
             continue;
         }
         
         throw std::runtime_error("Unknown char: " + std::string(1, c));
     }
-    tokens.push_back(makeToken(TokenType::EOF_TOKEN));
-    return tokens;
 }
@@ -2,8 +2,47 @@
 #include "link_str.h"
 #include <algorithm>
 #include <cctype> 
+#include <cstring>
+#include <charconv>
 
 namespace SysString {
+
+    // memchr jumps to each candidate first byte (libc scans with SSE2/AVX2
+    // where available) and memcmp verifies the rest, so one pass over the
+    // input finds every match without per-character branching here.
+    size_t find(std::string_view str, std::string_view needle, size_t from) {
+        if (from > str.size()) return std::string_view::npos;
+        if (needle.empty()) return from;
+        if (needle.size() > str.size() - from) return std::string_view::npos;
+
+        const char* base = str.data();
+        const char* p = base + from;
+        const char* last = base + str.size() - needle.size(); // Final start position
+        const char first = needle[0];
+        while (p <= last) {
+            p = static_cast<const char*>(std::memchr(p, first, (size_t)(last - p) + 1));
+            if (!p) break;
+            if (std::memcmp(p + 1, needle.data() + 1, needle.size() - 1) == 0) return (size_t)(p - base);
+            ++p;
+        }
+        return std::string_view::npos;
+    }
+
+    size_t count(std::string_view str, std::string_view needle) {
+        if (needle.empty()) return 0;
+        size_t n = 0;
+        for (size_t pos = find(str, needle); pos != std::string_view::npos; pos = find(str, needle, pos + needle.size())) ++n;
+        return n;
+    }
+
+    std::vector<size_t> findAll(std::string_view str, std::string_view needle) {
+        std::vector<size_t> hits;
+        if (needle.empty()) return hits;
+        for (size_t pos = find(str, needle); pos != std::string_view::npos; pos = find(str, needle, pos + needle.size())) {
+            hits.push_back(pos);
+        }
+        return hits;
+    }
 	
 	std::string pop(const std::string& input) {
         if (input.empty()) return ""; 
@@ -13,34 +52,54 @@ namespace SysString {
         return result;
     }
 
-    std::string trim(const std::string& str) {
-        const std::string whitespace = " \t\n\r";
+    std::string_view trimView(std::string_view str) {
+        const std::string_view whitespace = " \t\n\r";
         size_t first = str.find_first_not_of(whitespace);
-        if (std::string::npos == first) return "";
+        if (std::string_view::npos == first) return {};
         size_t last = str.find_last_not_of(whitespace);
         return str.substr(first, (last - first + 1));
     }
 
-    std::string replace(std::string str, const std::string& from, const std::string& to) {
+    std::string trim(const std::string& str) {
+        return std::string(trimView(str));
+    }
+
+    // Copies the gaps and replacements into a fresh result instead of
+    // shifting the tail of the input on every match
+    std::string replace(const std::string& str, const std::string& from, const std::string& to) {
         if (from.empty()) return str;
-        size_t start_pos = 0;
-        while ((start_pos = str.find(from, start_pos)) != std::string::npos) {
-            str.replace(start_pos, from.length(), to);
-            start_pos += to.length();
+        std::string result;
+        result.reserve(str.size());
+        size_t start = 0, pos;
+        while ((pos = SysString::find(str, from, start)) != std::string::npos) {
+            result.append(str, start, pos - start);
+            result += to;
+            start = pos + from.length();
         }
-        return str;
+        result.append(str, start, std::string::npos);
+        return result;
     }
 
-    std::vector<std::string> split(std::string str, const std::string& delimiter) {
-        std::vector<std::string> list;
-        size_t pos = 0;
-        std::string token;
-        while ((pos = str.find(delimiter)) != std::string::npos) {
-            token = str.substr(0, pos);
-            list.push_back(token);
-            str.erase(0, pos + delimiter.length());
+    // Scans forward from an offset instead of erasing the consumed prefix,
+    // so splitting is linear in the input
+    std::vector<std::string_view> splitView(std::string_view str, std::string_view delimiter) {
+        std::vector<std::string_view> list;
+        if (delimiter.empty()) {
+            list.push_back(str);
+            return list;
+        }
+        size_t start = 0, pos;
+        while ((pos = SysString::find(str, delimiter, start)) != std::string_view::npos) {
+            list.push_back(str.substr(start, pos - start));
+            start = pos + delimiter.length();
         }
-        list.push_back(str); // Sisa string terakhir
+        list.push_back(str.substr(start)); // Sisa string terakhir
+        return list;
+    }
+
+    std::vector<std::string> split(const std::string& str, const std::string& delimiter) {
+        std::vector<std::string> list;
+        for (std::string_view piece : splitView(str, delimiter)) list.emplace_back(piece);
         return list;
     }
 
@@ -53,11 +112,67 @@ namespace SysString {
         return result;
     }
     
-    std::string substring(const std::string& str, int start, int length) {
-        if (start < 0) return "";
-        if (start >= (int)str.length()) return "";
+    std::string_view substringView(std::string_view str, int start, int length) {
+        if (start < 0) return {};
+        if (start >= (int)str.length()) return {};
         return str.substr(start, length);
     }
+
+    static std::string_view numberStart(std::string_view str) {
+        size_t i = 0;
+        while (i < str.size() && std::isspace((unsigned char)str[i])) i++;
+        if (i + 1 < str.size() && str[i] == '+' && str[i + 1] != '-') i++;
+        return str.substr(i);
+    }
+
+    bool parseInt(std::string_view str, int& out) {
+        str = numberStart(str);
+        int value;
+        auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        if (ec != std::errc()) return false;
+        out = value;
+        return true;
+    }
+
+    bool parseDouble(std::string_view str, double& out) {
+        str = numberStart(str);
+        const char* first = str.data();
+        const char* last = first + str.size();
+        bool negative = first != last && *first == '-';
+        const char* digits = first + (negative ? 1 : 0);
+        double value;
+        if (last - digits > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+            // stod reads hex floats too; from_chars wants them without the prefix
+            auto [ptr, ec] = std::from_chars(digits + 2, last, value, std::chars_format::hex);
+            if (ec != std::errc()) return false;
+            out = negative ? -value : value;
+            return true;
+        }
+        auto [ptr, ec] = std::from_chars(first, last, value);
+        if (ec != std::errc()) return false;
+        out = value;
+        return true;
+    }
+
+    void appendInt(std::string& out, int value) {
+        char buf[16];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, end);
+    }
+
+    // Same text as the old std::to_string + trim: fixed notation with six
+    // decimals, then trailing zeros and a bare '.' removed
+    void appendDouble(std::string& out, double value) {
+        char buf[400]; // DBL_MAX in fixed notation needs 309 digits + sign + 7
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, 6);
+        while (end > buf && end[-1] == '0') --end;
+        if (end > buf && end[-1] == '.') --end;
+        out.append(buf, end);
+    }
+
+    std::string substring(const std::string& str, int start, int length) {
+        return std::string(substringView(str, start, length));
+    }
     
     std::string toLower(const std::string& str) {
         std::string result = str;
@@ -5,8 +5,11 @@
 #include "lexer.h"
 #include "parser.h"
 #include "runtime.h" 
+#include "optimizer.h"
+#include "vm.h"
 #include "help.h"
 #include "repl_core.h"
+#include "output.h"
 
 bool isBlockStart(const std::string& line) {
     size_t start = line.find_first_not_of(" \t");
@@ -31,11 +34,10 @@ bool isBlockStart(const std::string& line) {
     return false;
 }
 
-void run(Runtime& runtime, const std::string& source, bool isDebug) {
+void run(Runtime& runtime, VM* vm, const std::string& source, bool isDebug, bool dumpOpt) {
     try {
         Lexer lexer(source);
-        auto tokens = lexer.tokenize();
-        Parser parser(tokens);
+        Parser parser(lexer);
         auto program = parser.parse(); 
 
         if (isDebug) {
@@ -44,7 +46,15 @@ void run(Runtime& runtime, const std::string& source, bool isDebug) {
             std::cout << "----------------------------\n";
         }
 
-        runtime.execute(std::move(program)); 
+        Optimizer(runtime).optimize(*program);
+        if (dumpOpt) {
+            std::cout << "\n--- OPTIMIZED AST ---\n";
+            program->print();
+            std::cout << "---------------------\n";
+        }
+
+        if (vm) vm->execute(std::move(program), isDebug);
+        else runtime.execute(std::move(program)); 
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -68,18 +78,43 @@ int main(int argc, char** argv) {
         }
     }
 
-    // 2. Check the --debug flag
+    // 2. Check the --debug and --engine flags
     bool debugMode = false;
+    bool useVM = false;
+    bool unbuffered = false;
+    bool dumpOpt = false;
+    int flagCount = 0;
     for(int i=1; i<argc; i++) {
-        if(std::string(argv[i]) == "--debug") {
+        std::string arg = argv[i];
+        if (arg == "--debug") {
             debugMode = true;
-            break;
+            flagCount++;
+        } else if (arg == "--engine=vm") {
+            useVM = true;
+            flagCount++;
+        } else if (arg == "--engine=tree") {
+            flagCount++;
+        } else if (arg == "--unbuffered") {
+            unbuffered = true;
+            flagCount++;
+        } else if (arg == "--dump-opt") {
+            dumpOpt = true;
+            flagCount++;
+        } else if (arg.rfind("--engine=", 0) == 0) {
+            std::cout << "Error: Unknown engine '" << arg.substr(9) << "' (use 'tree' or 'vm')." << std::endl;
+            return 1;
         }
     }
 
-    if (argc < 2 || (argc == 2 && debugMode)) {
+    OutputBuffer::instance().install(unbuffered ? OutputBuffer::Mode::Unbuffered : OutputBuffer::defaultMode());
+
+    std::unique_ptr<VM> vm;
+    if (useVM) vm = std::make_unique<VM>(runtime);
+
+    if (argc - 1 == flagCount) {
         std::cout << "NebulaOS Link-Lang v0.3 (Analyzer)" << std::endl;
         if (debugMode) std::cout << "[DEBUG MODE ACTIVE]" << std::endl;
+        if (useVM) std::cout << "[BYTECODE VM ENGINE]" << std::endl;
         std::cout << "Type 'exit' to quit." << std::endl;
         ReplEditor editor;
         std::string inputBuffer;
@@ -100,13 +135,13 @@ int main(int argc, char** argv) {
                 } else {
                     if (!line.empty()) {
                         editor.addToHistory(line);
-                        run(runtime, line, debugMode);
+                        run(runtime, vm.get(), line, debugMode, dumpOpt);
                     }
                 }
             } else {
                 if (line.empty()) { 
                     editor.addToHistory(inputBuffer); 
-                    run(runtime, inputBuffer, debugMode);
+                    run(runtime, vm.get(), inputBuffer, debugMode, dumpOpt);
                     inputBuffer.clear();
                     indentLevel = 0; 
                 } else {
@@ -124,7 +159,7 @@ int main(int argc, char** argv) {
     std::string filename;
     for(int i=1; i<argc; i++) {
         std::string arg = argv[i];
-        if (arg != "--debug") {
+        if (arg != "--debug" && arg != "--unbuffered" && arg != "--dump-opt" && arg.rfind("--engine=", 0) != 0) {
             filename = arg;
             break;
         }
@@ -144,7 +179,7 @@ int main(int argc, char** argv) {
     std::string source((std::istreambuf_iterator<char>(file)),
                         std::istreambuf_iterator<char>());
 
-    run(runtime, source, debugMode);
+    run(runtime, vm.get(), source, debugMode, dumpOpt);
 
     return 0;        
 }
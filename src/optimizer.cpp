@@ -0,0 +1,212 @@
+#include "optimizer.h"
+#include "runtime.h"
+
+Optimizer::Optimizer(Runtime& runtime) : rt(runtime) {}
+
+void Optimizer::optimize(Program& program) {
+    arena = &program.arena;
+    block(program.statements);
+    arena = nullptr;
+}
+
+void Optimizer::block(std::vector<Node<Stmt>>& stmts) {
+    for (auto& stmt : stmts) statement(stmt.get());
+}
+
+void Optimizer::statement(Stmt* stmt) {
+    if (!stmt) return;
+    switch (stmt->kind) {
+    case StmtKind::Set:
+        expression(static_cast<SetStmt*>(stmt)->expression);
+        return;
+    case StmtKind::SetIndex: {
+        auto setIdx = static_cast<SetIndexStmt*>(stmt);
+        expression(setIdx->list);
+        expression(setIdx->index);
+        expression(setIdx->value);
+        return;
+    }
+    case StmtKind::While: {
+        auto loop = static_cast<WhileStmt*>(stmt);
+        expression(loop->condition);
+        block(loop->body);
+        return;
+    }
+    case StmtKind::If: {
+        auto ifStmt = static_cast<IfStmt*>(stmt);
+        expression(ifStmt->condition);
+        block(ifStmt->thenBranch);
+        block(ifStmt->elseBranch);
+        return;
+    }
+    case StmtKind::For: {
+        auto loop = static_cast<ForStmt*>(stmt);
+        expression(loop->collection);
+        block(loop->body);
+        return;
+    }
+    case StmtKind::Func:
+        block(static_cast<FuncDecl*>(stmt)->body);
+        return;
+    case StmtKind::Class:
+        for (auto& method : static_cast<ClassDecl*>(stmt)->methods) block(method->body);
+        return;
+    case StmtKind::Call:
+        for (auto& arg : static_cast<CallStmt*>(stmt)->args) expression(arg);
+        return;
+    case StmtKind::Return:
+        expression(static_cast<ReturnStmt*>(stmt)->value);
+        return;
+    case StmtKind::Try: {
+        auto tryStmt = static_cast<TryStmt*>(stmt);
+        block(tryStmt->tryBody);
+        block(tryStmt->catchBody);
+        return;
+    }
+    case StmtKind::App:
+        block(static_cast<AppDecl*>(stmt)->body);
+        return;
+    case StmtKind::Window:
+        block(static_cast<WindowDecl*>(stmt)->body);
+        return;
+    case StmtKind::Expr:
+        expression(static_cast<ExprStmt*>(stmt)->expression);
+        return;
+    default:
+        return;
+    }
+}
+
+// Takes the owning pointer so a folded node can be replaced in place
+void Optimizer::expression(Node<Expr>& expr) {
+    if (!expr) return;
+    switch (expr->kind) {
+    case ExprKind::Call:
+        for (auto& arg : static_cast<CallExpr*>(expr.get())->args) expression(arg);
+        return;
+    case ExprKind::MethodCall: {
+        auto call = static_cast<MethodCallExpr*>(expr.get());
+        expression(call->object);
+        for (auto& arg : call->args) expression(arg);
+        return;
+    }
+    case ExprKind::Get:
+        expression(static_cast<GetExpr*>(expr.get())->object);
+        return;
+    case ExprKind::Set: {
+        auto set = static_cast<SetExpr*>(expr.get());
+        expression(set->object);
+        expression(set->value);
+        return;
+    }
+    case ExprKind::Array:
+        for (auto& el : static_cast<ArrayExpr*>(expr.get())->elements) expression(el);
+        return;
+    case ExprKind::Dict:
+        for (auto& [key, val] : static_cast<DictExpr*>(expr.get())->pairs) {
+            expression(key);
+            expression(val);
+        }
+        return;
+    case ExprKind::Index: {
+        auto idx = static_cast<IndexExpr*>(expr.get());
+        expression(idx->object);
+        expression(idx->index);
+        return;
+    }
+    case ExprKind::Binary:
+        binary(expr);
+        return;
+    case ExprKind::Negate:
+        negate(expr);
+        return;
+    case ExprKind::New:
+        for (auto& arg : static_cast<NewExpr*>(expr.get())->args) expression(arg);
+        return;
+    default:
+        return;
+    }
+}
+
+void Optimizer::binary(Node<Expr>& expr) {
+    auto bin = static_cast<BinaryExpr*>(expr.get());
+    expression(bin->lhs);
+    expression(bin->rhs);
+    if (!bin->lhs || !bin->rhs) return;
+
+    if (isLiteral(bin->lhs.get()) && isLiteral(bin->rhs.get())) {
+        Obj result = rt.binaryOp(bin->op, literalValue(bin->lhs.get()), literalValue(bin->rhs.get()));
+        if (auto folded = makeLiteral(result)) expr = std::move(folded);
+        return;
+    }
+
+    // e * 1, 1 * e and e / 1 give back e unchanged when e can only be a
+    // number or nil (an int stays an int, -0.0 keeps its sign, nil * 1 is
+    // nil). e + 0 is not rewritten: -0.0 + 0 is +0.0.
+    auto isOne = [](const Expr* e) {
+        return e->kind == ExprKind::Number && static_cast<const NumberExpr*>(e)->value == 1;
+    };
+    Node<Expr>* keep = nullptr;
+    if ((bin->op == '*' || bin->op == '/') && isOne(bin->rhs.get()) && isNumberOrNil(bin->lhs.get())) {
+        keep = &bin->lhs;
+    } else if (bin->op == '*' && isOne(bin->lhs.get()) && isNumberOrNil(bin->rhs.get())) {
+        keep = &bin->rhs;
+    }
+    if (keep) {
+        Node<Expr> operand = std::move(*keep);
+        expr = std::move(operand);
+    }
+}
+
+void Optimizer::negate(Node<Expr>& expr) {
+    auto neg = static_cast<NegateExpr*>(expr.get());
+    expression(neg->operand);
+    if (!neg->operand || !isLiteral(neg->operand.get())) return;
+    if (auto folded = makeLiteral(rt.negate(literalValue(neg->operand.get())))) expr = std::move(folded);
+}
+
+// binaryOp only yields a number or nil for - * /, and so does negate,
+// whatever the operands are
+bool Optimizer::isNumberOrNil(const Expr* expr) {
+    switch (expr->kind) {
+    case ExprKind::Number: case ExprKind::Float: case ExprKind::Negate:
+        return true;
+    case ExprKind::Binary: {
+        char op = static_cast<const BinaryExpr*>(expr)->op;
+        return op == '-' || op == '*' || op == '/';
+    }
+    default:
+        return false;
+    }
+}
+
+bool Optimizer::isLiteral(const Expr* expr) {
+    switch (expr->kind) {
+    case ExprKind::Number: case ExprKind::Float: case ExprKind::String:
+    case ExprKind::Char: case ExprKind::Bool:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Obj Optimizer::literalValue(const Expr* expr) const {
+    switch (expr->kind) {
+    case ExprKind::Number: return Obj(static_cast<const NumberExpr*>(expr)->value);
+    case ExprKind::Float: return Obj(static_cast<const FloatExpr*>(expr)->value);
+    case ExprKind::String: return Obj(static_cast<const StringExpr*>(expr)->value);
+    case ExprKind::Char: return Obj(static_cast<const CharExpr*>(expr)->value);
+    case ExprKind::Bool: return Obj(static_cast<const BoolExpr*>(expr)->value);
+    default: return Obj();
+    }
+}
+
+// Returns null for values that have no literal form (nil)
+Node<Expr> Optimizer::makeLiteral(const Obj& value) {
+    if (value.isInt()) return Node<Expr>(arena->create<NumberExpr>(value.asInt()));
+    if (value.isDouble()) return Node<Expr>(arena->create<FloatExpr>(value.asDouble()));
+    if (value.isString()) return Node<Expr>(arena->create<StringExpr>(std::string(value.asLinkString().view())));
+    if (value.isBool()) return Node<Expr>(arena->create<BoolExpr>(value.asBool()));
+    if (value.isChar()) return Node<Expr>(arena->create<CharExpr>(value.asChar()));
+    return nullptr;
+}
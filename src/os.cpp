@@ -1,4 +1,5 @@
 #include "os.h"
+#include "link_str.h"
 #include <fstream>
 #include <sstream>
 #include <cstdio>
@@ -64,18 +65,32 @@ namespace Sys {
     }
 
     bool contains(const std::string& haystack, const std::string& needle) {
-        return haystack.find(needle) != std::string::npos;
+        return SysString::find(haystack, needle) != std::string::npos;
     }
 
+    // Shared by the lexer (string literals) and os.unescape. Unknown
+    // escapes are kept as written.
     std::string unescape(const std::string& s) {
-        std::string res = "";
+        std::string res;
+        res.reserve(s.length());
         for (size_t i = 0; i < s.length(); i++) {
             if (s[i] == '\\' && i + 1 < s.length()) {
                 switch (s[i + 1]) {
                     case 'n': res += '\n'; i++; break;
                     case 't': res += '\t'; i++; break;
+                    case 'r': res += '\r'; i++; break;
+                    case 'e': res += '\x1b'; i++; break;
                     case '\\': res += '\\'; i++; break;
                     case '"': res += '"'; i++; break;
+                    case '0': case '1': case '2': case '3': { // Octal, e.g. \033
+                        int code = 0, digits = 0;
+                        while (digits < 3 && i + 1 < s.length() && s[i + 1] >= '0' && s[i + 1] <= '7') {
+                            code = code * 8 + (s[++i] - '0');
+                            digits++;
+                        }
+                        res += (char)code;
+                        break;
+                    }
                     default: res += s[i]; break; 
                 }
             } else {
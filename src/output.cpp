@@ -0,0 +1,70 @@
+#include "output.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+OutputBuffer& OutputBuffer::instance() {
+    static OutputBuffer buffer;
+    return buffer;
+}
+
+OutputBuffer::OutputBuffer() {
+    pending.reserve(CAPACITY);
+}
+
+// Hands std::cout its own buffer back, so output written during static
+// destruction still has somewhere to go.
+OutputBuffer::~OutputBuffer() {
+    flush();
+    if (previous) std::cout.rdbuf(previous);
+}
+
+void OutputBuffer::install(Mode m) {
+    mode = m;
+    if (!previous) previous = std::cout.rdbuf(this);
+}
+
+OutputBuffer::Mode OutputBuffer::defaultMode() {
+    #ifdef _WIN32
+        return _isatty(_fileno(stdout)) ? Mode::Line : Mode::Buffered;
+    #else
+        return isatty(fileno(stdout)) ? Mode::Line : Mode::Buffered;
+    #endif
+}
+
+// Goes through stdio so text printed by C code (extern blocks) stays in order
+void OutputBuffer::flush() {
+    if (pending.empty()) return;
+    std::fwrite(pending.data(), 1, pending.size(), stdout);
+    std::fflush(stdout);
+    pending.clear();
+}
+
+void OutputBuffer::afterWrite(const char* s, size_t n) {
+    if (mode == Mode::Unbuffered || pending.size() >= CAPACITY) flush();
+    else if (mode == Mode::Line && std::memchr(s, '\n', n)) flush();
+}
+
+OutputBuffer::int_type OutputBuffer::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+    char c = traits_type::to_char_type(ch);
+    pending += c;
+    afterWrite(&c, 1);
+    return ch;
+}
+
+std::streamsize OutputBuffer::xsputn(const char* s, std::streamsize n) {
+    pending.append(s, (size_t)n);
+    afterWrite(s, (size_t)n);
+    return n;
+}
+
+int OutputBuffer::sync() {
+    flush();
+    return 0;
+}
@@ -2,23 +2,27 @@
 #include <stdexcept>
 #include <iostream>
 
-Parser::Parser(const std::vector<Token>& t) : tokens(t), current(0) {}
+Parser::Parser(Lexer& l) : lexer(l), current(0) { ring[0] = lexer.next(); }
 
-const Token& Parser::peek() const { return tokens[current]; }
-const Token& Parser::advance() { if (!isAtEnd()) current++; return tokens[current - 1]; }
+const Token& Parser::peek() const { return ring[current % RING]; }
+const Token& Parser::advance() {
+    if (!isAtEnd()) { current++; ring[current % RING] = lexer.next(); }
+    return previous();
+}
 bool Parser::match(TokenType type) { 
     if (isAtEnd()) return false;
     if (peek().type == type) { advance(); return true; } 
     return false;
 }
 const Token& Parser::consume(TokenType type, const std::string& err) { 
-    if (match(type)) return tokens[current - 1]; 
+    if (match(type)) return previous(); 
     throw std::runtime_error(err);
 }
 bool Parser::isAtEnd() const { return peek().type == TokenType::EOF_TOKEN; }
 
 std::unique_ptr<Program> Parser::parse() {
     auto program = std::make_unique<Program>();
+    arena = &program->arena;
     while (!isAtEnd()) {
         auto stmt = parseStatement();
         if (stmt) program->statements.push_back(std::move(stmt));
@@ -26,8 +30,8 @@ std::unique_ptr<Program> Parser::parse() {
     return program;
 }
 
-std::vector<std::unique_ptr<Expr>> Parser::parseArguments() {
-    std::vector<std::unique_ptr<Expr>> args;
+std::vector<Node<Expr>> Parser::parseArguments() {
+    std::vector<Node<Expr>> args;
     if (match(TokenType::LPAREN)) {
         if (peek().type != TokenType::RPAREN) {
             do {
@@ -39,36 +43,36 @@ std::vector<std::unique_ptr<Expr>> Parser::parseArguments() {
     return args;
 }
 
-std::unique_ptr<Stmt> Parser::parseStatement() {
-    if (match(TokenType::CLEAR) || match(TokenType::CLS)) return std::make_unique<ClearStmt>();
+Node<Stmt> Parser::parseStatement() {
+    if (match(TokenType::CLEAR) || match(TokenType::CLS)) return make<ClearStmt>();
     if (match(TokenType::CLASS)) return parseClass(); 
     if (match(TokenType::IMPORT)) {
-    std::string path = consume(TokenType::STRING, "Expected file path (string) after import").value;
-    return std::make_unique<ImportStmt>(path);
+    std::string path = consume(TokenType::STRING, "Expected file path (string) after import").text();
+    return make<ImportStmt>(path);
 }
 
     // --- EXTERN C++ PARSING LOGIC ---
     if (match(TokenType::EXTERN)) {
         consume(TokenType::STRING, "Expect language type after extern (e.g., \"c\")");
-        std::string lang = previous().value;
+        std::string lang = previous().text();
         
         // Capture optional flags
         std::string flags = "";
         if (peek().type == TokenType::STRING) {
-            flags = advance().value; 
+            flags = advance().text(); 
         }
         
         consume(TokenType::LBRACE, "Expect '{' before extern code block");
         
         std::string rawCode = "";
         if (peek().type == TokenType::STRING) {
-            rawCode = advance().value;
+            rawCode = advance().text();
         }
         
         consume(TokenType::RBRACE, "Expect '}' after extern block");
         
         // Ensure there are 3 arguments here: lang, flags, rawCode
-        return std::make_unique<ExternStmt>(lang, flags, rawCode);
+        return make<ExternStmt>(lang, flags, rawCode);
     }
     // ---------------------------------
 
@@ -82,16 +86,16 @@ std::unique_ptr<Stmt> Parser::parseStatement() {
     if (match(TokenType::FUNC)) 	return parseFunc();
     if (match(TokenType::CONNECT)) 	return parseConnect();
     if (match(TokenType::TRY)) 		return parseTry(); 
-    if (match(TokenType::BREAK))	return std::make_unique<BreakStmt>();
-    if (match(TokenType::CONTINUE))	return std::make_unique<ContinueStmt>(); 
+    if (match(TokenType::BREAK))	return make<BreakStmt>();
+    if (match(TokenType::CONTINUE))	return make<ContinueStmt>(); 
         
     if (match(TokenType::SH)){
-        auto command = consume(TokenType::STRING, "Error: 'sh' needs string").value;
-        return std::make_unique<PropertyStmt>("sh", command); 
+        auto command = consume(TokenType::STRING, "Error: 'sh' needs string").text();
+        return make<PropertyStmt>("sh", command); 
     }
 
     if (peek().type == TokenType::IDENTIFIER) {
-        std::string name = advance().value;
+        std::string name = advance().text();
         std::string method = "";
         bool isMethodCall = false;
         if (match(TokenType::DOT)) {
@@ -115,13 +119,14 @@ std::unique_ptr<Stmt> Parser::parseStatement() {
                 method = "init";
             }
             else {
-                method = consume(TokenType::IDENTIFIER, "Expected method").value;
+                method = consume(TokenType::IDENTIFIER, "Expected method").text();
             }
 
             if (name == "time" || name == "math" || name == "io"   || 
                 name == "os"   || name == "str"  || name == "list" ||
                 name == "fs"   || name == "term" || name == "dict" ||
-                name == "net"  || name == "audio"|| name == "gui") { // <-- Add here too
+                name == "net"  || name == "audio"|| name == "gui"  ||
+                name == "gc") { // <-- Add here too
                 
                 name += "." + method;
                 isMethodCall = false;
@@ -135,87 +140,87 @@ std::unique_ptr<Stmt> Parser::parseStatement() {
         if (match(TokenType::ASSIGN)) { 
             std::string fullName = name + (isMethodCall ? "." + method : "");
             auto value = parseExpression(); 
-            return std::make_unique<SetStmt>(fullName, std::move(value));
+            return make<SetStmt>(fullName, std::move(value));
         }
 
         // 2. Handle Increment (i++)
         if (match(TokenType::PLUS_PLUS)) {
             std::string fullName = name + (isMethodCall ? "." + method : "");
-            return std::make_unique<UpdateStmt>(fullName, "++"); 
+            return make<UpdateStmt>(fullName, "++"); 
         }
 
         // 3. Handle Print
         if (name == "print" && !isMethodCall) {
-            std::vector<std::unique_ptr<Expr>> args;
+            std::vector<Node<Expr>> args;
             if (peek().type == TokenType::LPAREN) args = parseArguments();
             else args.push_back(parseExpression()); 
-            return std::make_unique<CallStmt>("print", std::move(args));
+            return make<CallStmt>("print", std::move(args));
         }
 
         // 4. Handle Function/Method Call
         if (peek().type == TokenType::LPAREN) {
              auto args = parseArguments();
              if (isMethodCall) {
-                 auto objExpr = std::make_unique<VariableExpr>(name);
-                 auto methodCall = std::make_unique<MethodCallExpr>(
+                 auto objExpr = make<VariableExpr>(name);
+                 auto methodCall = make<MethodCallExpr>(
                      std::move(objExpr),
                      method,
                      std::move(args)
                  );
-                 return std::make_unique<ExprStmt>(std::move(methodCall));
+                 return make<ExprStmt>(std::move(methodCall));
              } else {
-                 return std::make_unique<CallStmt>(name, std::move(args));
+                 return make<CallStmt>(name, std::move(args));
              }
         } else {
-             std::vector<std::unique_ptr<Expr>> emptyArgs;
-             return std::make_unique<CallStmt>(name, std::move(emptyArgs));
+             std::vector<Node<Expr>> emptyArgs;
+             return make<CallStmt>(name, std::move(emptyArgs));
         }
     }
     advance(); 
     return nullptr;
 }
 
-std::unique_ptr<Expr> Parser::parseExpression() {
+Node<Expr> Parser::parseExpression() {
     return parseLogicOr();
 }
 
-std::unique_ptr<Expr> Parser::parseLogicOr() {
+Node<Expr> Parser::parseLogicOr() {
     auto left = parseLogicAnd();
     while (match(TokenType::OR)) {
         auto right = parseLogicAnd();
-        left = std::make_unique<BinaryExpr>('|', std::move(left), std::move(right));
+        left = make<BinaryExpr>('|', std::move(left), std::move(right));
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::parseLogicAnd() {
+Node<Expr> Parser::parseLogicAnd() {
     auto left = parseEquality();
     while (match(TokenType::AND)) {
         auto right = parseEquality();
-        left = std::make_unique<BinaryExpr>('&', std::move(left), std::move(right));
+        left = make<BinaryExpr>('&', std::move(left), std::move(right));
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::parseEquality() {
+Node<Expr> Parser::parseEquality() {
     auto left = parseBitwise();
     while (match(TokenType::LT) || match(TokenType::GT) || 
            match(TokenType::EQ_EQ) || match(TokenType::BANG_EQ)) {
                
-        std::string op = tokens[current - 1].value;
+        std::string op = previous().text();
         auto right = parseBitwise(); 
-        left = std::make_unique<BinaryExpr>(op[0], std::move(left), std::move(right));
+        left = make<BinaryExpr>(op[0], std::move(left), std::move(right));
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::parseBitwise() {
+Node<Expr> Parser::parseBitwise() {
     auto left = parseAdditive(); 
     
     while (match(TokenType::BIT_AND) || match(TokenType::BIT_OR) || 
            match(TokenType::XOR) || match(TokenType::LSHIFT) || match(TokenType::RSHIFT)) {
         
-        TokenType type = tokens[current - 1].type;
+        TokenType type = previous().type;
         char opCode = '?';
         if (type == TokenType::BIT_AND) opCode = '&'; 
         if (type == TokenType::BIT_OR)  opCode = '|';
@@ -224,46 +229,46 @@ std::unique_ptr<Expr> Parser::parseBitwise() {
         if (type == TokenType::RSHIFT)  opCode = 'R'; 
         
         auto right = parseAdditive();
-        left = std::make_unique<BinaryExpr>(opCode, std::move(left), std::move(right));
+        left = make<BinaryExpr>(opCode, std::move(left), std::move(right));
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::parseAdditive() {
+Node<Expr> Parser::parseAdditive() {
     auto left = parseTerm();
     while (match(TokenType::PLUS) || match(TokenType::MINUS)) {
-        char op = tokens[current - 1].value[0];
+        char op = previous().value[0];
         auto right = parseTerm(); 
-        left = std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
+        left = make<BinaryExpr>(op, std::move(left), std::move(right));
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::parseTerm() {
+Node<Expr> Parser::parseTerm() {
     auto left = parseUnary();
     while (match(TokenType::STAR) || match(TokenType::SLASH)) {
-        char op = tokens[current - 1].value[0];
+        char op = previous().value[0];
         auto right = parseUnary();
-        left = std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
+        left = make<BinaryExpr>(op, std::move(left), std::move(right));
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::parseUnary() {
+Node<Expr> Parser::parseUnary() {
     if (match(TokenType::MINUS)) {
         auto right = parseUnary();
-        return std::make_unique<BinaryExpr>('-', std::make_unique<NumberExpr>(0), std::move(right));
+        return make<NegateExpr>(std::move(right));
     }
     return parsePostfix();
 }
 
-std::unique_ptr<Expr> Parser::parsePostfix() {
+Node<Expr> Parser::parsePostfix() {
     auto expr = parsePrimary();
     while (true) {
         if (match(TokenType::LBRACKET)) {
             auto index = parseExpression();
             consume(TokenType::RBRACKET, "Expected ']' after index");
-            expr = std::make_unique<IndexExpr>(std::move(expr), std::move(index));
+            expr = make<IndexExpr>(std::move(expr), std::move(index));
         } 
         else if (match(TokenType::DOT)) {
             std::string name;
@@ -271,19 +276,20 @@ std::unique_ptr<Expr> Parser::parsePostfix() {
             if (match(TokenType::INIT)) {
                 name = "init";
             } else {
-                name = consume(TokenType::IDENTIFIER, "Expected property name").value;
+                name = consume(TokenType::IDENTIFIER, "Expected property name").text();
             }
-            expr = std::make_unique<GetExpr>(std::move(expr), name);
+            expr = make<GetExpr>(std::move(expr), name);
         }
         else if (match(TokenType::LPAREN)) {
-            if (auto getExpr = dynamic_cast<GetExpr*>(expr.get())) {
-                std::vector<std::unique_ptr<Expr>> args;
+            if (expr->kind == ExprKind::Get) {
+                auto getExpr = static_cast<GetExpr*>(expr.get());
+                std::vector<Node<Expr>> args;
                 if (peek().type != TokenType::RPAREN) {
                     do { args.push_back(parseExpression());
                     } while (match(TokenType::COMMA));
                 }
                 consume(TokenType::RPAREN, "Expected ')'");
-                expr = std::make_unique<MethodCallExpr>(
+                expr = make<MethodCallExpr>(
                     std::move(getExpr->object), 
                     getExpr->name, 
                     std::move(args)
@@ -304,31 +310,31 @@ std::unique_ptr<Expr> Parser::parsePostfix() {
            peek().type == TokenType::INDENT || \
            peek().type == TokenType::DEDENT) { advance(); }
 
-std::unique_ptr<Expr> Parser::parsePrimary() {
-    if (match(TokenType::THIS)) return std::make_unique<ThisExpr>(tokens[current - 1]);
+Node<Expr> Parser::parsePrimary() {
+    if (match(TokenType::THIS)) return make<ThisExpr>(previous().line);
     
     if (match(TokenType::NEW)) {
-        std::string className = consume(TokenType::IDENTIFIER, "Expected class name").value;
+        std::string className = consume(TokenType::IDENTIFIER, "Expected class name").text();
         consume(TokenType::LPAREN, "Expected '(' after class name");
-        std::vector<std::unique_ptr<Expr>> args;
+        std::vector<Node<Expr>> args;
         if (peek().type != TokenType::RPAREN) {
             do {
                 args.push_back(parseExpression());
             } while (match(TokenType::COMMA));
         }
         consume(TokenType::RPAREN, "Expected ')' after arguments");
-        return std::make_unique<NewExpr>(className, std::move(args));
+        return make<NewExpr>(className, std::move(args));
     }
 	
-    if (match(TokenType::TOKEN_NUM)) return std::make_unique<NumberExpr>(std::stoi(tokens[current - 1].value));
-    if (match(TokenType::TOKEN_FLOAT)) return std::make_unique<FloatExpr>(std::stod(tokens[current - 1].value));
-    if (match(TokenType::STRING)) return std::make_unique<StringExpr>(tokens[current - 1].value);
-    if (match(TokenType::CHAR)) return std::make_unique<CharExpr>(tokens[current - 1].value[0]);
-    if (match(TokenType::TRUE)) return std::make_unique<BoolExpr>(true);
-    if (match(TokenType::FALSE)) return std::make_unique<BoolExpr>(false);
+    if (match(TokenType::TOKEN_NUM)) return make<NumberExpr>(std::stoi(previous().text()));
+    if (match(TokenType::TOKEN_FLOAT)) return make<FloatExpr>(std::stod(previous().text()));
+    if (match(TokenType::STRING)) return make<StringExpr>(previous().text());
+    if (match(TokenType::CHAR)) return make<CharExpr>(previous().value[0]);
+    if (match(TokenType::TRUE)) return make<BoolExpr>(true);
+    if (match(TokenType::FALSE)) return make<BoolExpr>(false);
     
     if (match(TokenType::LBRACKET)) {
-        std::vector<std::unique_ptr<Expr>> elements;
+        std::vector<Node<Expr>> elements;
         SKIP_IGNORE 
         if (peek().type != TokenType::RBRACKET) {
             do {
@@ -339,11 +345,11 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
         }
         SKIP_IGNORE 
         consume(TokenType::RBRACKET, "Expected ']'");
-        return std::make_unique<ArrayExpr>(std::move(elements));
+        return make<ArrayExpr>(std::move(elements));
     }
 
     if (match(TokenType::LBRACE)) {
-        std::vector<std::pair<std::unique_ptr<Expr>, std::unique_ptr<Expr>>> pairs;
+        std::vector<std::pair<Node<Expr>, Node<Expr>>> pairs;
         SKIP_IGNORE 
         if (peek().type != TokenType::RBRACE) {
             do {
@@ -358,12 +364,12 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
         }
         SKIP_IGNORE 
         consume(TokenType::RBRACE, "Expected '}'");
-        return std::make_unique<DictExpr>(std::move(pairs));
+        return make<DictExpr>(std::move(pairs));
     }
 
     if (peek().type == TokenType::IDENTIFIER) {
         
-        std::string name = advance().value;
+        std::string name = advance().text();
         if (match(TokenType::DOT)) {
             std::string method = "";
             if (peek().type == TokenType::CONNECT) {
@@ -379,7 +385,7 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
                 method = "cls";
             }
             else {
-                method = consume(TokenType::IDENTIFIER, "Expected method").value;
+                method = consume(TokenType::IDENTIFIER, "Expected method").text();
             }
 
             name += "." + method; 
@@ -387,9 +393,9 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
         
         if (peek().type == TokenType::LPAREN) {
             auto args = parseArguments();
-            return std::make_unique<CallExpr>(name, std::move(args));
+            return make<CallExpr>(name, std::move(args));
         }
-        return std::make_unique<VariableExpr>(name);
+        return make<VariableExpr>(name);
     }
     
     if (match(TokenType::LPAREN)) {
@@ -397,10 +403,10 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
         consume(TokenType::RPAREN, "Butuh ')'");
         return expr;
     }
-    throw std::runtime_error("Unknown token: " + peek().value);
+    throw std::runtime_error("Unknown token: " + peek().text());
 }
 
-std::unique_ptr<Stmt> Parser::parseSet() {
+Node<Stmt> Parser::parseSet() {
     auto target = parsePostfix(); 
     TokenType opType = peek().type; 
     if (opType != TokenType::ASSIGN && 
@@ -417,28 +423,31 @@ std::unique_ptr<Stmt> Parser::parseSet() {
         if (opType == TokenType::STAR_EQ)  mathOp = '*';
         if (opType == TokenType::SLASH_EQ) mathOp = '/';
         
-        std::unique_ptr<Expr> leftSide = nullptr;
-        if (auto v = dynamic_cast<VariableExpr*>(target.get())) {
-            leftSide = std::make_unique<VariableExpr>(v->name);
+        Node<Expr> leftSide = nullptr;
+        if (target->kind == ExprKind::Variable) {
+            leftSide = make<VariableExpr>(static_cast<VariableExpr*>(target.get())->name);
         } 
         else {
              throw std::runtime_error("Compound assignment currently supports simple variables only.");
         }
-        value = std::make_unique<BinaryExpr>(mathOp, std::move(leftSide), std::move(value));
+        value = make<BinaryExpr>(mathOp, std::move(leftSide), std::move(value));
     }
-    if (auto varExpr = dynamic_cast<VariableExpr*>(target.get())) {
-        return std::make_unique<SetStmt>(varExpr->name, std::move(value));
+    if (target->kind == ExprKind::Variable) {
+        auto varExpr = static_cast<VariableExpr*>(target.get());
+        return make<SetStmt>(varExpr->name, std::move(value));
     } 
-    else if (auto getExpr = dynamic_cast<GetExpr*>(target.get())) {
-        auto setExpr = std::make_unique<SetExpr>(
+    else if (target->kind == ExprKind::Get) {
+        auto getExpr = static_cast<GetExpr*>(target.get());
+        auto setExpr = make<SetExpr>(
             std::move(getExpr->object),
             getExpr->name,
             std::move(value)
         );
-        return std::make_unique<ExprStmt>(std::move(setExpr));
+        return make<ExprStmt>(std::move(setExpr));
     }
-    else if (auto idxExpr = dynamic_cast<IndexExpr*>(target.get())) {
-        return std::make_unique<SetIndexStmt>(
+    else if (target->kind == ExprKind::Index) {
+        auto idxExpr = static_cast<IndexExpr*>(target.get());
+        return make<SetIndexStmt>(
             std::move(idxExpr->object), 
             std::move(idxExpr->index),  
             std::move(value)            
@@ -449,9 +458,9 @@ std::unique_ptr<Stmt> Parser::parseSet() {
 }
 
 
-std::unique_ptr<Stmt> Parser::parseWhile() {
+Node<Stmt> Parser::parseWhile() {
     auto condition = parseExpression();
-    auto stmt = std::make_unique<WhileStmt>(std::move(condition));
+    auto stmt = make<WhileStmt>(std::move(condition));
 
     if (match(TokenType::LBRACE)) {
         while (peek().type != TokenType::RBRACE && !isAtEnd()) {
@@ -474,22 +483,22 @@ std::unique_ptr<Stmt> Parser::parseWhile() {
     return stmt;
 }
 
-std::unique_ptr<AppDecl> Parser::parseApp() {
+Node<AppDecl> Parser::parseApp() {
     std::string name;
-    if (peek().type == TokenType::IDENTIFIER || peek().type == TokenType::STRING) name = advance().value;
+    if (peek().type == TokenType::IDENTIFIER || peek().type == TokenType::STRING) name = advance().text();
     else throw std::runtime_error("Error: App-name must be word");
     consume(TokenType::NEWLINE, "Newline needed");
     consume(TokenType::INDENT, "Indent needed");
-    auto app = std::make_unique<AppDecl>(name);
+    auto app = make<AppDecl>(name);
     while (!match(TokenType::DEDENT) && !isAtEnd()) {
         auto stmt = parseStatement(); if (stmt) app->body.push_back(std::move(stmt));
     }
     return app;
 }
 
-std::unique_ptr<Stmt> Parser::parseIf() {
+Node<Stmt> Parser::parseIf() {
     auto condition = parseExpression();
-    auto stmt = std::make_unique<IfStmt>(std::move(condition));
+    auto stmt = make<IfStmt>(std::move(condition));
     if (match(TokenType::LBRACE)) {
         while (peek().type != TokenType::RBRACE && !isAtEnd()) {
             if (peek().type == TokenType::NEWLINE || peek().type == TokenType::INDENT || peek().type == TokenType::DEDENT) {
@@ -536,12 +545,12 @@ std::unique_ptr<Stmt> Parser::parseIf() {
     return stmt;
 }
 
-std::unique_ptr<Stmt> Parser::parseFor() {
-    auto iteratorName = consume(TokenType::IDENTIFIER, "Expected iterator variable").value;
+Node<Stmt> Parser::parseFor() {
+    auto iteratorName = consume(TokenType::IDENTIFIER, "Expected iterator variable").text();
     consume(TokenType::IN, "Expected 'in' after iterator");
     auto collection = parseExpression();
     
-    auto forStmt = std::make_unique<ForStmt>(iteratorName, std::move(collection));
+    auto forStmt = make<ForStmt>(iteratorName, std::move(collection));
 
     if (match(TokenType::LBRACE)) {
         while (peek().type != TokenType::RBRACE && !isAtEnd()) {
@@ -564,11 +573,11 @@ std::unique_ptr<Stmt> Parser::parseFor() {
     return forStmt;
 }
 
-std::unique_ptr<WindowDecl> Parser::parseWindow() {
-    auto name = consume(TokenType::IDENTIFIER, "Expected window name").value;
+Node<WindowDecl> Parser::parseWindow() {
+    auto name = consume(TokenType::IDENTIFIER, "Expected window name").text();
     consume(TokenType::NEWLINE, "Expected newline");
     consume(TokenType::INDENT, "Expected indent");
-    auto window = std::make_unique<WindowDecl>(name);
+    auto window = make<WindowDecl>(name);
     while (!match(TokenType::DEDENT) && !isAtEnd()) {
         auto stmt = parseStatement();
         if (stmt) window->body.push_back(std::move(stmt));
@@ -576,19 +585,19 @@ std::unique_ptr<WindowDecl> Parser::parseWindow() {
     return window;
 }
 
-std::unique_ptr<FuncDecl> Parser::parseFunc() {
+Node<FuncDecl> Parser::parseFunc() {
     std::string name;
     if (match(TokenType::INIT)) name = "init";
-    else name = consume(TokenType::IDENTIFIER, "Expected func name").value;
+    else name = consume(TokenType::IDENTIFIER, "Expected func name").text();
     std::vector<std::string> params;
     if (match(TokenType::LPAREN)) {
         if (peek().type != TokenType::RPAREN) {
-            do { params.push_back(consume(TokenType::IDENTIFIER, "Expected param").value);
+            do { params.push_back(consume(TokenType::IDENTIFIER, "Expected param").text());
             } while (match(TokenType::COMMA));
         }
         consume(TokenType::RPAREN, "Expected ')'");
     }
-    auto func = std::make_unique<FuncDecl>(name, params);
+    auto func = make<FuncDecl>(name, params);
     if (match(TokenType::LBRACE)) {
         while (peek().type != TokenType::RBRACE && !isAtEnd()) {
             if (peek().type == TokenType::NEWLINE || peek().type == TokenType::INDENT || peek().type == TokenType::DEDENT) { advance(); continue; }
@@ -607,52 +616,52 @@ std::unique_ptr<FuncDecl> Parser::parseFunc() {
     return func;
 }
 
-std::unique_ptr<Stmt> Parser::parseClass() {
-    std::string name = consume(TokenType::IDENTIFIER, "Expected class name").value;
+Node<Stmt> Parser::parseClass() {
+    std::string name = consume(TokenType::IDENTIFIER, "Expected class name").text();
     consume(TokenType::LBRACE, "Expected '{'");
-    std::vector<std::unique_ptr<FuncDecl>> methods;
+    std::vector<Node<FuncDecl>> methods;
     while (peek().type != TokenType::RBRACE && !isAtEnd()) {
         if (match(TokenType::FUNC)) { methods.push_back(parseFunc()); } 
         else { advance(); }
     }
     consume(TokenType::RBRACE, "Expected '}'");
-    return std::make_unique<ClassDecl>(name, std::move(methods));
+    return make<ClassDecl>(name, std::move(methods));
 }
 
-std::unique_ptr<ConnectStmt> Parser::parseConnect() {
-    auto source = consume(TokenType::IDENTIFIER, "Expected source").value;
+Node<ConnectStmt> Parser::parseConnect() {
+    auto source = consume(TokenType::IDENTIFIER, "Expected source").text();
     consume(TokenType::DOT, "Expected dot");
-    auto event = consume(TokenType::IDENTIFIER, "Expected event").value;
+    auto event = consume(TokenType::IDENTIFIER, "Expected event").text();
     consume(TokenType::ARROW, "Expected arrow");
-    auto target = consume(TokenType::IDENTIFIER, "Expected target").value;
-    return std::make_unique<ConnectStmt>(source, event, target);
+    auto target = consume(TokenType::IDENTIFIER, "Expected target").text();
+    return make<ConnectStmt>(source, event, target);
 }
 
-std::unique_ptr<Stmt> Parser::parseReturn() {
-    std::unique_ptr<Expr> value = nullptr;
+Node<Stmt> Parser::parseReturn() {
+    Node<Expr> value = nullptr;
     if (peek().type != TokenType::NEWLINE && peek().type != TokenType::DEDENT && peek().type != TokenType::EOF_TOKEN) { 
          value = parseExpression();
     }
     if (!isAtEnd() && peek().type == TokenType::NEWLINE) advance();
-    return std::make_unique<ReturnStmt>(std::move(value));
+    return make<ReturnStmt>(std::move(value));
 }
 
-std::unique_ptr<Stmt> Parser::parseTry() {
+Node<Stmt> Parser::parseTry() {
     consume(TokenType::LBRACE, "Expected '{'");
-    std::vector<std::unique_ptr<Stmt>> tryBody;
+    std::vector<Node<Stmt>> tryBody;
     while (peek().type != TokenType::RBRACE && !isAtEnd()) {
         tryBody.push_back(parseStatement());
     }
     consume(TokenType::RBRACE, "Expected '}'");
     consume(TokenType::CATCH, "Expected 'catch'");
     consume(TokenType::LPAREN, "Expected '('");
-    std::string errorVar = consume(TokenType::IDENTIFIER, "Expected var").value;
+    std::string errorVar = consume(TokenType::IDENTIFIER, "Expected var").text();
     consume(TokenType::RPAREN, "Expected ')'");
     consume(TokenType::LBRACE, "Expected '{'");
-    std::vector<std::unique_ptr<Stmt>> catchBody;
+    std::vector<Node<Stmt>> catchBody;
     while (peek().type != TokenType::RBRACE && !isAtEnd()) {
         catchBody.push_back(parseStatement());
     }
     consume(TokenType::RBRACE, "Expected '}'");
-    return std::make_unique<TryStmt>(std::move(tryBody), std::move(catchBody), errorVar);
+    return make<TryStmt>(std::move(tryBody), std::move(catchBody), errorVar);
 }
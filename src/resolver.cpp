@@ -0,0 +1,290 @@
+#include "resolver.h"
+
+Resolver::Resolver(std::shared_ptr<ScopeLayout> globals) : globals(std::move(globals)) {}
+
+void Resolver::resolve(Program& program) {
+    Scope global{globals.get(), nullptr};
+    globalScope = &global;
+    declare(program.statements, global);
+    block(program.statements, global);
+    globalScope = nullptr;
+}
+
+// Mirrors every Environment::define the runtime performs in this scope
+// (loop iterators, nested functions and classes). Catch blocks and function
+// bodies get their own scopes, so they are not descended into here.
+void Resolver::declare(const std::vector<Node<Stmt>>& stmts, Scope& scope) {
+    for (auto& stmt : stmts) {
+        if (!stmt) continue;
+        switch (stmt->kind) {
+        case StmtKind::For: {
+            auto loop = static_cast<ForStmt*>(stmt.get());
+            scope.layout->declare(loop->iteratorName);
+            declare(loop->body, scope);
+            break;
+        }
+        case StmtKind::While:
+            declare(static_cast<WhileStmt*>(stmt.get())->body, scope);
+            break;
+        case StmtKind::If: {
+            auto ifStmt = static_cast<IfStmt*>(stmt.get());
+            declare(ifStmt->thenBranch, scope);
+            declare(ifStmt->elseBranch, scope);
+            break;
+        }
+        case StmtKind::Try:
+            declare(static_cast<TryStmt*>(stmt.get())->tryBody, scope);
+            break;
+        case StmtKind::Func:
+            scope.layout->declare(static_cast<FuncDecl*>(stmt.get())->name);
+            break;
+        case StmtKind::Class:
+            scope.layout->declare(static_cast<ClassDecl*>(stmt.get())->name);
+            break;
+        case StmtKind::Import:
+            scope.dynamic = true;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void Resolver::block(const std::vector<Node<Stmt>>& stmts, Scope& scope) {
+    for (auto& stmt : stmts) statement(stmt.get(), scope);
+}
+
+void Resolver::statement(Stmt* stmt, Scope& scope) {
+    if (!stmt) return;
+    switch (stmt->kind) {
+    case StmtKind::Set: {
+        auto set = static_cast<SetStmt*>(stmt);
+        if (set->expression) expression(set->expression.get(), scope);
+        lookup(set->name, scope, set->depth, set->slot);
+        if (set->expression && set->expression->kind == ExprKind::Binary) {
+            auto bin = static_cast<BinaryExpr*>(set->expression.get());
+            if (bin->op == '+' && bin->lhs && bin->lhs->kind == ExprKind::Variable &&
+                static_cast<VariableExpr*>(bin->lhs.get())->name == set->name) {
+                set->append = bin;
+            }
+        }
+        return;
+    }
+    case StmtKind::SetIndex: {
+        auto setIdx = static_cast<SetIndexStmt*>(stmt);
+        expression(setIdx->list.get(), scope);
+        expression(setIdx->index.get(), scope);
+        expression(setIdx->value.get(), scope);
+        return;
+    }
+    case StmtKind::While: {
+        auto loop = static_cast<WhileStmt*>(stmt);
+        expression(loop->condition.get(), scope);
+        block(loop->body, scope);
+        return;
+    }
+    case StmtKind::If: {
+        auto ifStmt = static_cast<IfStmt*>(stmt);
+        expression(ifStmt->condition.get(), scope);
+        block(ifStmt->thenBranch, scope);
+        block(ifStmt->elseBranch, scope);
+        return;
+    }
+    case StmtKind::For: {
+        auto loop = static_cast<ForStmt*>(stmt);
+        expression(loop->collection.get(), scope);
+        loop->slot = scope.layout->lookup(loop->iteratorName);
+        block(loop->body, scope);
+        return;
+    }
+    case StmtKind::Func:
+        function(static_cast<FuncDecl*>(stmt), scope, false);
+        return;
+    case StmtKind::Class:
+        // Methods run in a fresh frame whose parent is the global scope
+        for (auto& method : static_cast<ClassDecl*>(stmt)->methods) {
+            function(method.get(), *globalScope, true);
+        }
+        return;
+    case StmtKind::Call: {
+        auto call = static_cast<CallStmt*>(stmt);
+        for (auto& arg : call->args) expression(arg.get(), scope);
+        lookup(call->func, scope, call->site.depth, call->site.slot);
+        return;
+    }
+    case StmtKind::Return: {
+        auto ret = static_cast<ReturnStmt*>(stmt);
+        if (ret->value) expression(ret->value.get(), scope);
+        return;
+    }
+    case StmtKind::Try: {
+        auto tryStmt = static_cast<TryStmt*>(stmt);
+        block(tryStmt->tryBody, scope);
+
+        Scope catchScope{tryStmt->catchLayout.get(), &scope};
+        catchScope.layout->declare(tryStmt->errorVar);
+        declare(tryStmt->catchBody, catchScope);
+        block(tryStmt->catchBody, catchScope);
+        return;
+    }
+    case StmtKind::Expr: {
+        auto exprStmt = static_cast<ExprStmt*>(stmt);
+        if (exprStmt->expression) expression(exprStmt->expression.get(), scope);
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+void Resolver::expression(Expr* expr, Scope& scope) {
+    if (!expr) return;
+    switch (expr->kind) {
+    case ExprKind::Variable: {
+        auto var = static_cast<VariableExpr*>(expr);
+        lookup(var->name, scope, var->depth, var->slot);
+        return;
+    }
+    case ExprKind::This: {
+        auto self = static_cast<ThisExpr*>(expr);
+        lookup(atoms::self, scope, self->depth, self->slot);
+        return;
+    }
+    case ExprKind::Call: {
+        auto call = static_cast<CallExpr*>(expr);
+        for (auto& arg : call->args) expression(arg.get(), scope);
+        lookup(call->func, scope, call->site.depth, call->site.slot);
+        return;
+    }
+    case ExprKind::MethodCall: {
+        auto call = static_cast<MethodCallExpr*>(expr);
+        expression(call->object.get(), scope);
+        for (auto& arg : call->args) expression(arg.get(), scope);
+        return;
+    }
+    case ExprKind::Get:
+        expression(static_cast<GetExpr*>(expr)->object.get(), scope);
+        return;
+    case ExprKind::Set: {
+        auto set = static_cast<SetExpr*>(expr);
+        expression(set->object.get(), scope);
+        expression(set->value.get(), scope);
+        return;
+    }
+    case ExprKind::Array:
+        for (auto& el : static_cast<ArrayExpr*>(expr)->elements) expression(el.get(), scope);
+        return;
+    case ExprKind::Dict:
+        for (auto& [key, val] : static_cast<DictExpr*>(expr)->pairs) {
+            expression(key.get(), scope);
+            expression(val.get(), scope);
+        }
+        return;
+    case ExprKind::Index: {
+        auto idx = static_cast<IndexExpr*>(expr);
+        expression(idx->object.get(), scope);
+        expression(idx->index.get(), scope);
+        return;
+    }
+    case ExprKind::Binary: {
+        auto bin = static_cast<BinaryExpr*>(expr);
+        expression(bin->lhs.get(), scope);
+        expression(bin->rhs.get(), scope);
+        return;
+    }
+    case ExprKind::Negate:
+        expression(static_cast<NegateExpr*>(expr)->operand.get(), scope);
+        return;
+    case ExprKind::New:
+        for (auto& arg : static_cast<NewExpr*>(expr)->args) expression(arg.get(), scope);
+        return;
+    default:
+        return;
+    }
+}
+
+// An import in an enclosing scope may add names the Resolver cannot see,
+// and extern blocks read variables by name, so those functions keep their
+// whole defining environment instead of capturing.
+void Resolver::function(FuncDecl* fn, Scope& parent, bool isMethod) {
+    fn->capturesEnv = containsExtern(fn->body);
+    for (Scope* s = &parent; s != globalScope; s = s->parent) {
+        if (s->dynamic) fn->capturesEnv = true;
+    }
+    fn->captures.clear();
+
+    Scope scope{fn->layout.get(), &parent};
+    scope.function = fn;
+    if (isMethod) scope.layout->declare(atoms::self);
+    for (auto& param : fn->params) scope.layout->declare(param);
+    declare(fn->body, scope);
+    block(fn->body, scope);
+}
+
+bool Resolver::containsExtern(const std::vector<Node<Stmt>>& stmts) {
+    for (auto& stmt : stmts) {
+        if (!stmt) continue;
+        switch (stmt->kind) {
+        case StmtKind::Extern:
+            return true;
+        case StmtKind::While:
+            if (containsExtern(static_cast<WhileStmt*>(stmt.get())->body)) return true;
+            break;
+        case StmtKind::For:
+            if (containsExtern(static_cast<ForStmt*>(stmt.get())->body)) return true;
+            break;
+        case StmtKind::If: {
+            auto ifStmt = static_cast<IfStmt*>(stmt.get());
+            if (containsExtern(ifStmt->thenBranch) || containsExtern(ifStmt->elseBranch)) return true;
+            break;
+        }
+        case StmtKind::Try: {
+            auto tryStmt = static_cast<TryStmt*>(stmt.get());
+            if (containsExtern(tryStmt->tryBody) || containsExtern(tryStmt->catchBody)) return true;
+            break;
+        }
+        case StmtKind::Func:
+            if (containsExtern(static_cast<FuncDecl*>(stmt.get())->body)) return true;
+            break;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+// Returns the scope that owns the name, or nullptr (depth left at -1) when
+// an import could shadow it at runtime. Names no scope declares belong to
+// the global scope, which is where Environment::assign creates them.
+Resolver::Scope* Resolver::lookup(Atom name, Scope& scope, int& depth, int& slot) {
+    int distance = 0;
+    for (Scope* s = &scope; s; s = s->parent, ++distance) {
+        int found = s->layout->lookup(name);
+        if (found < 0 && !s->parent) found = s->layout->declare(name);
+        if (found >= 0) {
+            depth = distance;
+            slot = found;
+            return s;
+        }
+        if (s->dynamic) return nullptr;
+
+        // Leaving a closure-converted function: its frame's parent is the
+        // global frame, and anything in between becomes a capture
+        if (s->function && !s->function->capturesEnv && s->parent != globalScope) {
+            int outerDepth = -1, outerSlot = -1;
+            Scope* owner = lookup(name, *s->parent, outerDepth, outerSlot);
+            if (!owner) return nullptr;
+            if (owner == globalScope) {
+                depth = distance + 1;
+                slot = outerSlot;
+                return owner;
+            }
+            int target = s->layout->declare(name);
+            s->function->captures.push_back({outerDepth, outerSlot, target});
+            depth = distance;
+            slot = target;
+            return s;
+        }
+    }
+    return nullptr;
+}
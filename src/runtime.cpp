@@ -26,14 +26,19 @@
 #include <filesystem>
 #include <random> 
 #include "types.h"  
-#include "env.h"    
+#include "env.h"
+#include "gc.h"    
 #include "lexer.h" 
 #include "parser.h" 
+#include "resolver.h"
+#include "optimizer.h"
 #include "os.h" 
 #include "link_str.h"
+#include "output.h"
 #include "link_math.h"
 #include "link_net.h"
 #include "runtime.h"
+#include "native_bind.h"
 #include "link_gui.h"
 #include "link_wrapper.h"
 #include "link_audio.h"
@@ -43,8 +48,9 @@ static std::random_device rd;
 static std::mt19937 gen(rd()); 
 
 Runtime::Runtime() {
-    globalEnv = std::make_shared<Environment>();
+    globalEnv = Environment::make();
     currentEnv = globalEnv;
+    argStack.reserve(256);
     initNativeFunctions(); 
 }
 
@@ -60,22 +66,22 @@ std::string Runtime::getAnsiColor(const std::string& color) {
 }
 
 std::string Runtime::objToString(const Obj& val) {
-    if (std::holds_alternative<int>(val.as)) {
-        return std::to_string(std::get<int>(val.as));
-    }
-    if (std::holds_alternative<double>(val.as)) {
-        std::string s = std::to_string(std::get<double>(val.as));
-        s.erase(s.find_last_not_of('0') + 1, std::string::npos);
-        if (s.back() == '.') s.pop_back();
-        return s;
-    }
-    if (std::holds_alternative<std::string>(val.as)) {
-        return std::get<std::string>(val.as);
-    }
-    if (std::holds_alternative<bool>(val.as)) {
-        return std::get<bool>(val.as) ? "true" : "false";
-    }
-    return ""; 
+    std::string s;
+    appendToString(s, val);
+    return s;
+}
+
+// Formats straight into out, so `"score: " + n` builds one string
+void Runtime::appendToString(std::string& out, const Obj& val) {
+    if (val.isInt()) SysString::appendInt(out, val.asInt());
+    else if (val.isDouble()) SysString::appendDouble(out, val.asDouble());
+    else if (val.isString()) out += val.asLinkString().view();
+    else if (val.isBool()) out += val.asBool() ? "true" : "false";
+}
+
+LinkString Runtime::toLinkString(const Obj& val) {
+    if (val.isString()) return val.asLinkString();
+    return LinkString(objToString(val));
 }
 
 char getChar() {
@@ -96,10 +102,10 @@ char getChar() {
 
 void Runtime::initNativeFunctions() {
     
-    nativeRegistry["print"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["print"] = [](Runtime& rt, ArgSpan args) -> Obj {
     for (size_t i = 0; i < args.size(); ++i) {
-        std::string rawOutput = objToString(args[i]);
-        std::cout << Sys::unescape(rawOutput);
+        if (args[i].isString()) std::cout << args[i].asLinkString().view();
+        else std::cout << rt.objToString(args[i]);
         
         if (i < args.size() - 1) std::cout << " ";
     }
@@ -110,12 +116,9 @@ void Runtime::initNativeFunctions() {
     // ==========================================
     // 1. NETWORKING MODULE (SysNet)
     // ==========================================
-    nativeRegistry["net.socket"] = [](const std::vector<Obj>& args) -> Obj {
-        int s = SysNet::createSocket();
-        return Obj(s);
-    };
+    bind<&SysNet::createSocket>("net.socket");
 
-    nativeRegistry["net.server"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["net.server"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj(-1);
         int port = 80;
         if (std::holds_alternative<int>(args[0].as)) port = std::get<int>(args[0].as);
@@ -130,7 +133,7 @@ void Runtime::initNativeFunctions() {
     };
 
     // 2. Accept Client (Blocking)
-    nativeRegistry["net.accept"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["net.accept"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj(-1);
         if (std::holds_alternative<int>(args[0].as)) {
             int serverSock = std::get<int>(args[0].as);
@@ -141,11 +144,11 @@ void Runtime::initNativeFunctions() {
     };
 
     // 3. Client Connect
-    nativeRegistry["net.connect"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["net.connect"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 2) return Obj(-1);
         std::string ip = "127.0.0.1";
         int port = 80;
-        if (std::holds_alternative<std::string>(args[0].as)) ip = std::get<std::string>(args[0].as);
+        if (args[0].isString()) ip = args[0].asString();
         if (std::holds_alternative<int>(args[1].as)) port = std::get<int>(args[1].as);
 
         int s = SysNet::createSocket();
@@ -154,16 +157,10 @@ void Runtime::initNativeFunctions() {
     };
 
     // 4. Send Data
-    nativeRegistry["net.send"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 2) return Obj(false);
-        if (std::holds_alternative<int>(args[0].as)) {
-            return Obj(SysNet::sendData(std::get<int>(args[0].as), objToString(args[1])));
-        }
-        return Obj(false);
-    };
+    bind<&SysNet::sendData>("net.send");
 
     // 5. Receive Data
-    nativeRegistry["net.recv"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["net.recv"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj("");
         if (std::holds_alternative<int>(args[0].as)) {
             return Obj(SysNet::receiveData(std::get<int>(args[0].as)));
@@ -172,30 +169,26 @@ void Runtime::initNativeFunctions() {
     };
 
     // 6. Close
-    nativeRegistry["net.close"] = [](const std::vector<Obj>& args) -> Obj {
-        if (!args.empty() && std::holds_alternative<int>(args[0].as)) {
-            SysNet::closeSocket(std::get<int>(args[0].as));
-        }
-        return Obj(0);
-    };
+    bind<&SysNet::closeSocket>("net.close");
 
     // ==========================================
     // 2. TYPE CASTING & CONVERSION
     // ==========================================
-    nativeRegistry["int"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["int"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj(0);
         const Obj& val = args[0];
         
         if (std::holds_alternative<int>(val.as)) return val;
         if (std::holds_alternative<double>(val.as)) return Obj((int)std::get<double>(val.as));
         if (std::holds_alternative<bool>(val.as)) return Obj(std::get<bool>(val.as) ? 1 : 0);
-        if (std::holds_alternative<std::string>(val.as)) {
-            try { return Obj(std::stoi(std::get<std::string>(val.as))); } 
-            catch(...) { return Obj(0); }
+        if (val.isString()) {
+            int value = 0;
+            SysString::parseInt(val.asLinkString().view(), value);
+            return Obj(value);
         }
         return Obj(0);
     };
-    nativeRegistry["char"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["char"] = [](Runtime& rt, ArgSpan args) -> Obj {
     if (args.empty()) return Obj("");
     int code = 0;
     if (std::holds_alternative<int>(args[0].as)) code = std::get<int>(args[0].as);
@@ -204,60 +197,58 @@ void Runtime::initNativeFunctions() {
     std::string s(1, (char)code);
     return Obj(s);
     };
-    nativeRegistry["float"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["float"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj(0.0);
         const Obj& val = args[0];
         if (std::holds_alternative<double>(val.as)) return val;
         if (std::holds_alternative<int>(val.as)) return Obj((double)std::get<int>(val.as));
-        if (std::holds_alternative<std::string>(val.as)) {
-            try { return Obj(std::stod(std::get<std::string>(val.as))); } 
-            catch(...) { return Obj(0.0); }
+        if (val.isString()) {
+            double value = 0.0;
+            SysString::parseDouble(val.asLinkString().view(), value);
+            return Obj(value);
         }
         return Obj(0.0);
     };
-    nativeRegistry["str"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["str"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj("");
-        return Obj(objToString(args[0]));
+        return Obj(rt.objToString(args[0]));
     };
     // ==========================================
     // 3. SYSTEM & IO
     // ==========================================
-    nativeRegistry["term.getch"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["term.getch"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        OutputBuffer::instance().flush(); // Show the prompt before blocking
         char c = getChar(); // Ensure getChar() is visible here
         return Obj(std::string(1, c));
     };
-    nativeRegistry["term.color"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["term.color"] = [](Runtime& rt, ArgSpan args) -> Obj {
     if (args.empty()) return Obj("");
-    std::string colorName = objToString(args[0]);
-    return Obj(getAnsiColor(colorName)); 
+    std::string colorName = rt.objToString(args[0]);
+    return Obj(rt.getAnsiColor(colorName)); 
 	};
-    nativeRegistry["term.reset"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["term.reset"] = [](Runtime& rt, ArgSpan args) -> Obj {
         return Obj("\033[0m");
     };
-    nativeRegistry["time.sleep"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["time.sleep"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj(0);
         int ms = 0;
         if (std::holds_alternative<int>(args[0].as)) ms = std::get<int>(args[0].as);
         else if (std::holds_alternative<double>(args[0].as)) ms = (int)std::get<double>(args[0].as);
+        OutputBuffer::instance().flush(); // Animations draw a frame, then sleep
         std::this_thread::sleep_for(std::chrono::milliseconds(ms));
         return Obj(0);
     };
-    nativeRegistry["os.exec"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["os.exec"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj("");
-        return Obj(Sys::exec(objToString(args[0]).c_str())); 
+        OutputBuffer::instance().flush(); // Keep ordering with the child's output
+        return Obj(Sys::exec(rt.objToString(args[0]).c_str())); 
     };
-    nativeRegistry["os.cwd"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["os.cwd"] = [](Runtime& rt, ArgSpan args) -> Obj {
         return Obj(fs::current_path().string());
     };
-    nativeRegistry["os.getenv"] = [this](const std::vector<Obj>& args) -> Obj {
-         if (args.empty()) return Obj("");
-         return Obj(Sys::getEnv(objToString(args[0])));
-    };
-	nativeRegistry["os.unescape"] = [this](const std::vector<Obj>& args) -> Obj {
-    if (args.empty()) return Obj("");
-    return Obj(Sys::unescape(objToString(args[0])));
-    };
-    nativeRegistry["os.date"] = [this](const std::vector<Obj>& args) -> Obj {
+    bind<&Sys::getEnv>("os.getenv");
+    bind<&Sys::unescape>("os.unescape");
+    nativeRegistry["os.date"] = [](Runtime& rt, ArgSpan args) -> Obj {
         std::time_t t = std::time(nullptr);
         char buffer[100];
         std::strftime(buffer, sizeof(buffer), "%H:%M", std::localtime(&t));
@@ -267,28 +258,22 @@ void Runtime::initNativeFunctions() {
     // ==========================================
     // 4. FILESYSTEM (FS) & IO
     // ==========================================
-    nativeRegistry["io.read"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["io.read"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj("");
-        if (std::holds_alternative<std::string>(args[0].as)) {
-            std::string path = std::get<std::string>(args[0].as);
+        if (args[0].isString()) {
+            std::string path = args[0].asString();
             if (!Sys::fileExists(path)) return Obj(""); // Or throw an error
             return Obj(Sys::readFile(path));
         }
         return Obj("");
     };
-    nativeRegistry["io.exists"] = [](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj(false);
-        if (std::holds_alternative<std::string>(args[0].as)) {
-            return Obj(Sys::fileExists(std::get<std::string>(args[0].as)));
-        }
-        return Obj(false);
-    };
-    nativeRegistry["fs.list"] = [](const std::vector<Obj>& args) -> Obj {
+    bind<&Sys::fileExists>("io.exists");
+    nativeRegistry["fs.list"] = [](Runtime& rt, ArgSpan args) -> Obj {
         std::string path = ".";
-        if (!args.empty() && std::holds_alternative<std::string>(args[0].as)) {
-            path = std::get<std::string>(args[0].as);
+        if (!args.empty() && args[0].isString()) {
+            path = args[0].asString();
         }
-        auto list = std::make_shared<List>();
+        auto list = Collector::instance().track(std::make_shared<List>());
         try {
             for (const auto& entry : fs::directory_iterator(path)) {
                 list->push_back(Obj(entry.path().filename().string()));
@@ -296,17 +281,17 @@ void Runtime::initNativeFunctions() {
         } catch(...) {}
         return Obj(list);
     };
-    nativeRegistry["fs.isdir"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["fs.isdir"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj(false);
-        if (std::holds_alternative<std::string>(args[0].as)) {
-             try { return Obj(fs::is_directory(std::get<std::string>(args[0].as))); }
+        if (args[0].isString()) {
+             try { return Obj(fs::is_directory(args[0].asString())); }
              catch(...) { return Obj(false); }
         }
         return Obj(false);
     };
-    nativeRegistry["fs.mkdir"] = [](const std::vector<Obj>& args) -> Obj {
-        if (!args.empty() && std::holds_alternative<std::string>(args[0].as)) {
-            try { fs::create_directory(std::get<std::string>(args[0].as)); } catch(...) {}
+    nativeRegistry["fs.mkdir"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        if (!args.empty() && args[0].isString()) {
+            try { fs::create_directory(args[0].asString()); } catch(...) {}
         }
         return Obj(0);
     };
@@ -314,10 +299,10 @@ void Runtime::initNativeFunctions() {
     // ==========================================
     // 5. STRING LIBRARY
     // ==========================================
-    nativeRegistry["len"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["len"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj(0);
-        if (std::holds_alternative<std::string>(args[0].as)) 
-            return Obj((int)std::get<std::string>(args[0].as).length());
+        if (args[0].isString()) 
+            return Obj((int)args[0].asLinkString().size());
         if (std::holds_alternative<std::shared_ptr<List>>(args[0].as))
             return Obj((int)std::get<std::shared_ptr<List>>(args[0].as)->size());
          if (std::holds_alternative<std::shared_ptr<Dict>>(args[0].as))
@@ -325,90 +310,100 @@ void Runtime::initNativeFunctions() {
         return Obj(0);
     };
 
-    nativeRegistry["str.sub"] = [](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 3) return Obj("");
-        if (std::holds_alternative<std::string>(args[0].as) &&
-            std::holds_alternative<int>(args[1].as) &&
-            std::holds_alternative<int>(args[2].as)) {
-            return Obj(SysString::substring(
-                std::get<std::string>(args[0].as), 
-                std::get<int>(args[1].as), 
-                std::get<int>(args[2].as)
-            ));
-        }
-        return Obj("");
+    // sub, trim and split return slices of their input instead of copies
+    nativeRegistry["str.sub"] = [](Runtime&, ArgSpan args) -> Obj {
+        if (args.size() < 3 || !args[0].isString() || !args[1].isInt() || !args[2].isInt()) return Obj("");
+        const LinkString& str = args[0].asLinkString();
+        return Obj(str.slice(SysString::substringView(str.view(), args[1].asInt(), args[2].asInt())));
     };
 
-    nativeRegistry["str.lower"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj("");
-        return Obj(SysString::toLower(objToString(args[0])));
-    };
+    bind<&SysString::toLower>("str.lower");
     
-    nativeRegistry["str.upper"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj("");
-        return Obj(SysString::toUpper(objToString(args[0])));
-    };
+    bind<&SysString::toUpper>("str.upper");
 
-    nativeRegistry["str.trim"] = [](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj("");
-        if (std::holds_alternative<std::string>(args[0].as)) {
-            return Obj(SysString::trim(std::get<std::string>(args[0].as)));
-        }
-        return Obj("");
+    nativeRegistry["str.trim"] = [](Runtime&, ArgSpan args) -> Obj {
+        if (args.empty() || !args[0].isString()) return Obj("");
+        const LinkString& str = args[0].asLinkString();
+        return Obj(str.slice(SysString::trimView(str.view())));
     };
 
-    nativeRegistry["str.replace"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 3) return Obj("");
-        return Obj(SysString::replace(
-            objToString(args[0]), objToString(args[1]), objToString(args[2])
-        ));
-    };
+    bind<&SysString::replace>("str.replace");
     
-    nativeRegistry["str.split"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 2) return Obj(std::make_shared<List>());
-        auto vec = SysString::split(objToString(args[0]), objToString(args[1]));
-        auto list = std::make_shared<List>();
-        for(const auto& v : vec) list->push_back(Obj(v));
+    nativeRegistry["str.split"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        if (args.size() < 2) return Obj(Collector::instance().track(std::make_shared<List>()));
+        LinkString str = rt.toLinkString(args[0]);
+        LinkString delimiter = rt.toLinkString(args[1]);
+        auto list = Collector::instance().track(std::make_shared<List>());
+        for (std::string_view piece : SysString::splitView(str.view(), delimiter.view())) {
+            list->push_back(Obj(str.slice(piece)));
+        }
         return Obj(list);
     };
 
-    nativeRegistry["str.contains"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["str.contains"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 2) return Obj(false);
-        return Obj(Sys::contains(objToString(args[0]), objToString(args[1])));
+        LinkString str = rt.toLinkString(args[0]);
+        LinkString needle = rt.toLinkString(args[1]);
+        return Obj(SysString::find(str.view(), needle.view()) != std::string_view::npos);
     };
-    
-    nativeRegistry["str.pop"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj("");
-        std::string input = objToString(args[0]);
-        return Obj(SysString::pop(input));
+
+    // str.find(s, needle, [start]) -> index of the first match or -1
+    nativeRegistry["str.find"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        if (args.size() < 2) return Obj(-1);
+        LinkString str = rt.toLinkString(args[0]);
+        LinkString needle = rt.toLinkString(args[1]);
+        int start = args.size() > 2 ? nativeToInt(args[2]) : 0;
+        if (start < 0) start = 0;
+        size_t pos = SysString::find(str.view(), needle.view(), (size_t)start);
+        return Obj(pos == std::string_view::npos ? -1 : (int)pos);
+    };
+
+    // str.count(s, needle) -> number of non-overlapping matches
+    nativeRegistry["str.count"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        if (args.size() < 2) return Obj(0);
+        LinkString str = rt.toLinkString(args[0]);
+        LinkString needle = rt.toLinkString(args[1]);
+        return Obj((int)SysString::count(str.view(), needle.view()));
+    };
+
+    // str.find_all(s, needle) -> list of match indexes
+    nativeRegistry["str.find_all"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        auto list = Collector::instance().track(std::make_shared<List>());
+        if (args.size() < 2) return Obj(list);
+        LinkString str = rt.toLinkString(args[0]);
+        LinkString needle = rt.toLinkString(args[1]);
+        for (size_t pos : SysString::findAll(str.view(), needle.view())) list->push_back(Obj((int)pos));
+        return Obj(list);
     };
-    nativeRegistry["str.starts_with"] = [this](const std::vector<Obj>& args) -> Obj {
+    
+    bind<&SysString::pop>("str.pop");
+    nativeRegistry["str.starts_with"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 2) return Obj(false);
-        std::string full = objToString(args[0]);
-        std::string prefix = objToString(args[1]);
+        std::string full = rt.objToString(args[0]);
+        std::string prefix = rt.objToString(args[1]);
         return Obj(full.rfind(prefix, 0) == 0);
     };
 
     // 3. str.substr("cd Desktop", 3) -> "Desktop" (Substring operation)
-    nativeRegistry["str.substr"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["str.substr"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 2) return Obj("");
-        std::string str = objToString(args[0]);
+        LinkString str = rt.toLinkString(args[0]);
         
         int start = 0;
         if (std::holds_alternative<int>(args[1].as)) start = std::get<int>(args[1].as);
         else if (std::holds_alternative<double>(args[1].as)) start = (int)std::get<double>(args[1].as);
 
-        if (start >= str.length()) return Obj("");
-        return Obj(str.substr(start));
+        if (start < 0 || (size_t)start >= str.size()) return Obj("");
+        return Obj(str.slice(str.view().substr((size_t)start)));
     };
-    nativeRegistry["str.merge"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["str.merge"] = [](Runtime& rt, ArgSpan args) -> Obj {
     if (args.size() < 2) return Obj("");
     if (!std::holds_alternative<std::shared_ptr<List>>(args[0].as)) return Obj("");
     auto listPtr = std::get<std::shared_ptr<List>>(args[0].as);
-    std::string delimiter = objToString(args[1]);
+    std::string delimiter = rt.objToString(args[1]);
     std::vector<std::string> strList;
     for (const auto& item : *listPtr) {
-        strList.push_back(objToString(item));
+        strList.push_back(rt.objToString(item));
     }
 
     return Obj(SysString::merge(strList, delimiter));
@@ -418,21 +413,12 @@ void Runtime::initNativeFunctions() {
     // ==========================================
     // 6. MATH LIBRARY
     // ==========================================
-    auto asInt = [](const Obj& o) -> int {
-        if (std::holds_alternative<int>(o.as)) return std::get<int>(o.as);
-        if (std::holds_alternative<double>(o.as)) return (int)std::get<double>(o.as);
-        if (std::holds_alternative<std::string>(o.as)) {
-            try { return std::stoi(std::get<std::string>(o.as)); } catch(...) { return 0; }
-        }
-        return 0;
-    };
-
-    nativeRegistry["math.random"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["math.random"] = [](Runtime& rt, ArgSpan args) -> Obj {
         std::uniform_real_distribution<> dis(0.0, 1.0);
         return Obj(dis(gen)); 
     };
 
-    nativeRegistry["math.randint"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["math.randint"] = [](Runtime& rt, ArgSpan args) -> Obj {
         int minV = 0, maxV = 100;
         if (args.size() >= 1 && std::holds_alternative<int>(args[0].as)) minV = std::get<int>(args[0].as);
         if (args.size() >= 2 && std::holds_alternative<int>(args[1].as)) maxV = std::get<int>(args[1].as);
@@ -440,33 +426,18 @@ void Runtime::initNativeFunctions() {
         return Obj(dis(gen));
     };
 
-    nativeRegistry["math.pi"] = [](const std::vector<Obj>& args) -> Obj { return Obj(SysMath::pi()); };
+    bind<&SysMath::pi>("math.pi");
     
-    nativeRegistry["math.sin"] = [asInt](const std::vector<Obj>& args) -> Obj { 
-        return args.empty() ? Obj(0.0) : Obj(SysMath::sin(asInt(args[0]))); 
-    };
-    nativeRegistry["math.cos"] = [asInt](const std::vector<Obj>& args) -> Obj { 
-        return args.empty() ? Obj(0.0) : Obj(SysMath::cos(asInt(args[0]))); 
-    };
-    nativeRegistry["math.sqrt"] = [asInt](const std::vector<Obj>& args) -> Obj { 
-        return args.empty() ? Obj(0.0) : Obj(SysMath::sqrt(asInt(args[0]))); 
-    };
-    nativeRegistry["math.pow"] = [asInt](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 2) return Obj(0.0);
-        double base = asInt(args[0]);
-        double exp = asInt(args[1]);
-        return Obj(std::pow(base, exp));
-    };
-    nativeRegistry["math.abs"] = [asInt](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj(0.0);
-        double val = asInt(args[0]);
-        return Obj(std::abs(val)); 
-    };
+    bind<&SysMath::sin>("math.sin");
+    bind<&SysMath::cos>("math.cos");
+    bind<&SysMath::sqrt>("math.sqrt");
+    bind<&SysMath::pow>("math.pow");
+    bind<&SysMath::abs>("math.abs");
     
     // ==========================================
     // 7. COLLECTIONS (List & Dict)
     // ==========================================
-    nativeRegistry["list.pop"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["list.pop"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) return Obj();
         if (std::holds_alternative<std::shared_ptr<List>>(args[0].as)) {
             auto list = std::get<std::shared_ptr<List>>(args[0].as);
@@ -478,63 +449,67 @@ void Runtime::initNativeFunctions() {
         }
         return Obj();
     };
-    nativeRegistry["range"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["range"] = [](Runtime& rt, ArgSpan args) -> Obj {
         int limit = 0;
         if (!args.empty() && std::holds_alternative<int>(args[0].as)) limit = std::get<int>(args[0].as);
-        auto list = std::make_shared<List>();
+        auto list = Collector::instance().track(std::make_shared<List>());
         for(int i=0; i<limit; i++) list->push_back(Obj(i));
         return Obj(list);
     };
-    nativeRegistry["term.clear"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["term.clear"] = [](Runtime& rt, ArgSpan args) -> Obj {
         std::cout << "\033[2J\033[H";
         return Obj(0);
     };
-    nativeRegistry["term.move"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["term.move"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() >= 2) {
-            int r = std::stoi(objToString(args[0]));
-            int c = std::stoi(objToString(args[1]));
-            std::cout << "\033[" << r << ";" << c << "H" << std::flush;
+            int r = std::stoi(rt.objToString(args[0]));
+            int c = std::stoi(rt.objToString(args[1]));
+            std::cout << "\033[" << r << ";" << c << "H";
         }
         return Obj(0);
     };
-    nativeRegistry["os.chdir"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["os.chdir"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (!args.empty()) {
-            std::string path = objToString(args[0]);
+            std::string path = rt.objToString(args[0]);
             try { fs::current_path(path); } 
             catch (...) { std::cout << "Error: Cannot move to '" << path << "'\n"; }
         }
         return Obj(0);
     };
-    nativeRegistry["os.setenv"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["os.setenv"] = [](Runtime& rt, ArgSpan args) -> Obj {
          if (args.size() >= 2) {
-             Sys::setEnv(objToString(args[0]), objToString(args[1]));
+             Sys::setEnv(rt.objToString(args[0]), rt.objToString(args[1]));
          }
          return Obj(0);
     };
-    nativeRegistry["io.remove"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (!args.empty()) Sys::removeFile(objToString(args[0]));
+    nativeRegistry["io.remove"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        if (!args.empty()) Sys::removeFile(rt.objToString(args[0]));
         return Obj(0);
     };
-    nativeRegistry["io.write"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["io.write"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 2) return Obj(0);
-        std::string path = objToString(args[0]);
-        std::string content = objToString(args[1]);
-        if (path == "stdout") std::cout << content << std::flush;
+        std::string path = rt.objToString(args[0]);
+        std::string content = rt.objToString(args[1]);
+        if (path == "stdout") std::cout << content;
         else Sys::writeFile(path, content, false);
         return Obj(0);
     };
-    nativeRegistry["io.append"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["io.flush"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        OutputBuffer::instance().flush();
+        return Obj(0);
+    };
+    nativeRegistry["io.append"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 2) return Obj(0);
-        Sys::writeFile(objToString(args[0]), objToString(args[1]), true);
+        Sys::writeFile(rt.objToString(args[0]), rt.objToString(args[1]), true);
         return Obj(0);
     };
-    nativeRegistry["list.add"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["list.add"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() >= 2 && std::holds_alternative<std::shared_ptr<List>>(args[0].as)) {
             std::get<std::shared_ptr<List>>(args[0].as)->push_back(args[1]);
         }
         return Obj(0);
     };
-        nativeRegistry["list.insert"] = [](const std::vector<Obj>& args) -> Obj {
+        nativeRegistry["list.insert"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() >= 3 && std::holds_alternative<std::shared_ptr<List>>(args[0].as) && 
             std::holds_alternative<int>(args[1].as)) {
             auto list = std::get<std::shared_ptr<List>>(args[0].as);
@@ -547,7 +522,7 @@ void Runtime::initNativeFunctions() {
         return Obj(false);
     };
 
-    nativeRegistry["list.remove"] = [](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["list.remove"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() >= 2 && std::holds_alternative<std::shared_ptr<List>>(args[0].as) && 
             std::holds_alternative<int>(args[1].as)) {
             auto list = std::get<std::shared_ptr<List>>(args[0].as);
@@ -560,162 +535,93 @@ void Runtime::initNativeFunctions() {
         return Obj(false);
     };
 
+    // ==========================================
+    // GC MODULE (cycle collector, see gc.h)
+    // ==========================================
+    nativeRegistry["gc.collect"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        return Obj((int)Collector::instance().collect());
+    };
+    nativeRegistry["gc.stats"] = [](Runtime& rt, ArgSpan args) -> Obj {
+        Collector::Stats stats = Collector::instance().stats();
+        auto dict = Collector::instance().track(std::make_shared<Dict>());
+        (*dict)["tracked"] = Obj((int)stats.tracked);
+        (*dict)["collections"] = Obj((int)stats.collections);
+        (*dict)["freed"] = Obj((int)stats.freed);
+        (*dict)["last_freed"] = Obj((int)stats.lastFreed);
+        return Obj(dict);
+    };
+
     // ==========================================
     // GUI MODULE (Bridge to src/link_gui.cpp)
     // ==========================================
     
-    nativeRegistry["gui_get_char"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::getCharPressed());
-    };
-    nativeRegistry["gui_get_key"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::getKeyPressed());
-    };
-    nativeRegistry["gui_is_key_down"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj(false);
-        return Obj(SysGui::isKeyDown(objToString(args[0])));
-    };
+    bind<&SysGui::getCharPressed>("gui_get_char");
+    bind<&SysGui::getKeyPressed>("gui_get_key");
+    bind<&SysGui::isKeyDown>("gui_is_key_down");
 
-    nativeRegistry["gui_measure_text"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 2) return Obj(0);
-        std::string txt = objToString(args[0]);
-        int size = std::stoi(objToString(args[1]));
-        return Obj(SysGui::measureText(txt, size));
-    };
+    bind<&SysGui::measureText>("gui_measure_text");
 
-    nativeRegistry["gui_debug"] = [](const std::vector<Obj>& args) -> Obj {
-        SysGui::enableDebug();
-        return Obj(0);
-    };
+    bind<&SysGui::enableDebug>("gui_debug");
 
-    nativeRegistry["gui_setup"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 3) return Obj(0);
-        
-        int w = 800; 
-        int h = 600;
-        
-        // Get width (args[0])
-        if (std::holds_alternative<int>(args[0].as)) w = std::get<int>(args[0].as);
-        else if (std::holds_alternative<double>(args[0].as)) w = (int)std::get<double>(args[0].as);
-        
-        // Get height (args[1])
-        if (std::holds_alternative<int>(args[1].as)) h = std::get<int>(args[1].as);
-        else if (std::holds_alternative<double>(args[1].as)) h = (int)std::get<double>(args[1].as);
-        
-        std::string title = objToString(args[2]);
-        
-        SysGui::setup(w, h, title);
-        return Obj(0);
-    };
+    bind<&SysGui::setup>("gui_setup");
 
-    nativeRegistry["gui_close"] = [](const std::vector<Obj>& args) -> Obj {
-        SysGui::close();
-        return Obj(0);
-    };
+    bind<&SysGui::close>("gui_close");
 
-    nativeRegistry["gui_running"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::running());
-    };
+    bind<&SysGui::running>("gui_running");
 
-    nativeRegistry["gui_start"] = [](const std::vector<Obj>& args) -> Obj {
-        SysGui::start();
-        return Obj(0);
-    };
+    bind<&SysGui::start>("gui_start");
     
-    nativeRegistry["gui_present"] = [](const std::vector<Obj>& args) -> Obj {
-        SysGui::present();
-        return Obj(0);
-    };
+    bind<&SysGui::present>("gui_present");
 
-    nativeRegistry["gui_clear"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["gui_clear"] = [](Runtime& rt, ArgSpan args) -> Obj {
     std::string color = "white";
-    if (!args.empty()) color = objToString(args[0]); 
+    if (!args.empty()) color = rt.objToString(args[0]); 
     SysGui::clear(color);
     return Obj(0);
     };
 
-    nativeRegistry["gui_text"] = [asInt, this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["gui_text"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 3) return Obj(0);
-        int x = asInt(args[0]);
-        int y = asInt(args[1]);
-        std::string text = objToString(args[2]);
+        int x = nativeToInt(args[0]);
+        int y = nativeToInt(args[1]);
+        std::string text = rt.objToString(args[2]);
         std::string color = "black";
         int size = 20;
         
-        if (args.size() >= 4) color = objToString(args[3]);
-        if (args.size() >= 5) size = asInt(args[4]);
+        if (args.size() >= 4) color = rt.objToString(args[3]);
+        if (args.size() >= 5) size = nativeToInt(args[4]);
 
         SysGui::drawText(x, y, text, color, size);
         return Obj(0);
     };
     
-    nativeRegistry["gui_rect"] = [asInt, this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 5) return Obj(0);
-        int x = asInt(args[0]);
-        int y = asInt(args[1]);
-        int w = asInt(args[2]);
-        int h = asInt(args[3]);
-        std::string color = objToString(args[4]);
-        SysGui::drawRect(x, y, w, h, color);
-        return Obj(0);
-    };
+    bind<&SysGui::drawRect>("gui_rect");
 
-	nativeRegistry["gui_is_mouse_down"] = [this](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::isMouseDown());
-    };
+    bind<&SysGui::isMouseDown>("gui_is_mouse_down");
 
-    nativeRegistry["gui.mouse_x"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::getMouseX());
-    };
-    nativeRegistry["gui.mouse_y"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::getMouseY());
-    };
+    bind<&SysGui::getMouseX>("gui.mouse_x");
+    bind<&SysGui::getMouseY>("gui.mouse_y");
 
-    nativeRegistry["gui_click"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::isMousePressed());
-    };
+    bind<&SysGui::isMousePressed>("gui_click");
     
-    nativeRegistry["gui_key"] = [this](const std::vector<Obj>& args) -> Obj { 
-        if (args.empty()) return Obj(false);
-        std::string key = objToString(args[0]);
-        return Obj(SysGui::isKeyDown(key));
-    };
-    nativeRegistry["gui_load_font"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 2) return Obj(0);
-        std::string path = objToString(args[0]);
-        int size = std::stoi(objToString(args[1]));
-        SysGui::loadFont(path, size);
-        return Obj(0);
-    };
-    nativeRegistry["gui_is_key_pressed"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.empty()) return Obj(false);
-        std::string key = objToString(args[0]);
-        return Obj(SysGui::isKeyPressed(key));
-    };
-    nativeRegistry["gui.measure_height"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() < 2) return Obj(0);
-        std::string text = objToString(args[0]);
-        
-        int size = 20; 
-        if (std::holds_alternative<int>(args[1].as)) size = std::get<int>(args[1].as);
-        
-        return Obj(SysGui::measureTextHeight(text, size));
-    };
-    nativeRegistry["gui.get_mouse_wheel"] = [this](const std::vector<Obj>& args) -> Obj {
-        return Obj((double)SysGui::getMouseWheel());
-    };
+    bind<&SysGui::isKeyDown>("gui_key");
+    bind<&SysGui::loadFont>("gui_load_font");
+    bind<&SysGui::isKeyPressed>("gui_is_key_pressed");
+    bind<&SysGui::measureTextHeight>("gui.measure_height");
+    bind<&SysGui::getMouseWheel>("gui.get_mouse_wheel");
 
-    nativeRegistry["gui_load_image"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["gui_load_image"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 2) return Obj(false);
-        std::string path = objToString(args[0]);
-        std::string name = objToString(args[1]);
+        std::string path = rt.objToString(args[0]);
+        std::string name = rt.objToString(args[1]);
         
         SysGui::loadImage(path, name);
         return Obj(true);
     };
 
-    nativeRegistry["gui_draw_image"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["gui_draw_image"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.size() < 5) return Obj(false);
-        std::string name = objToString(args[0]);
+        std::string name = rt.objToString(args[0]);
         int x = std::get<int>(args[1].as);
         int y = std::get<int>(args[2].as);
         int w = std::get<int>(args[3].as);
@@ -724,281 +630,423 @@ void Runtime::initNativeFunctions() {
         SysGui::drawImage(name, x, y, w, h);
         return Obj(true);
     };
-    nativeRegistry["gui.width"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::getScreenWidth());
-    };
-    nativeRegistry["gui.height"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::getScreenHeight());
-    };
-    nativeRegistry["gui_quit"] = [](const std::vector<Obj>& args) -> Obj {
+    bind<&SysGui::getScreenWidth>("gui.width");
+    bind<&SysGui::getScreenHeight>("gui.height");
+    nativeRegistry["gui_quit"] = [](Runtime& rt, ArgSpan args) -> Obj {
     SysGui::stop();
     return Obj(true);
     };
-    nativeRegistry["gui_get_time"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj(SysGui::getTime());
-    };
+    bind<&SysGui::getTime>("gui_get_time");
 
     // ==========================================
     // AUDIO MODULE (Bridge to src/link_audio.cpp)
     // ==========================================
-    nativeRegistry["audio.init"] = [](const std::vector<Obj>& args) -> Obj {
-        SysAudio::init();
-        return Obj(0);
-    };
+    bind<&SysAudio::init>("audio.init");
 
-    nativeRegistry["audio.get_eq"] = [](const std::vector<Obj>& args) -> Obj {
-        if (!args.empty() && std::holds_alternative<int>(args[0].as)) {
-            int band = std::get<int>(args[0].as);
-            return Obj((double)SysAudio::getSpectrum(band));
-        }
-        return Obj(0.0);
-    };
+    bind<&SysAudio::getSpectrum>("audio.get_eq");
 
-    nativeRegistry["audio.play"] = [this](const std::vector<Obj>& args) -> Obj {
+    nativeRegistry["audio.play"] = [](Runtime& rt, ArgSpan args) -> Obj {
         if (args.empty()) {
             SysAudio::resume(); // If called without arguments, treat it as Resume
             return Obj(true);
         }
-        std::string path = objToString(args[0]);
+        std::string path = rt.objToString(args[0]);
         return Obj(SysAudio::play(path)); // Load dan Play lagu baru
     };
 
-    nativeRegistry["audio.pause"] = [](const std::vector<Obj>& args) -> Obj {
-        SysAudio::pause();
-        return Obj(0);
-    };
+    bind<&SysAudio::pause>("audio.pause");
 
-    nativeRegistry["audio.stop"] = [](const std::vector<Obj>& args) -> Obj {
-        SysAudio::stop();
-        return Obj(0);
-    };
+    bind<&SysAudio::stop>("audio.stop");
 
-    nativeRegistry["audio.update"] = [](const std::vector<Obj>& args) -> Obj {
-        SysAudio::update();
-        return Obj(0);
-    };
+    bind<&SysAudio::update>("audio.update");
 
-    nativeRegistry["audio.volume"] = [](const std::vector<Obj>& args) -> Obj {
-        if (!args.empty() && std::holds_alternative<double>(args[0].as)) {
-            SysAudio::setVolume((float)std::get<double>(args[0].as));
-        }
-        return Obj(0);
-    };
+    bind<&SysAudio::setVolume>("audio.volume");
 
-    nativeRegistry["audio.length"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj((double)SysAudio::getTimeLength());
-    };
+    bind<&SysAudio::getTimeLength>("audio.length");
 
-    nativeRegistry["audio.played"] = [](const std::vector<Obj>& args) -> Obj {
-        return Obj((double)SysAudio::getTimePlayed());
-    };
+    bind<&SysAudio::getTimePlayed>("audio.played");
 
-    nativeRegistry["audio.seek"] = [](const std::vector<Obj>& args) -> Obj {
-        if (!args.empty() && std::holds_alternative<double>(args[0].as)) {
-            SysAudio::seek((float)std::get<double>(args[0].as));
-        }
-        return Obj(0);
-    };
+    bind<&SysAudio::seek>("audio.seek");
 
-    nativeRegistry["audio.close"] = [](const std::vector<Obj>& args) -> Obj {
-        SysAudio::close();
-        return Obj(0);
-    };
-    nativeRegistry["audio.load_sound"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (args.size() >= 2) {
-            SysAudio::loadSound(objToString(args[0]), objToString(args[1]));
-        }
-        return Obj(0);
-    };
+    bind<&SysAudio::close>("audio.close");
+    bind<&SysAudio::loadSound>("audio.load_sound");
 
-    nativeRegistry["audio.play_sound"] = [this](const std::vector<Obj>& args) -> Obj {
-        if (!args.empty()) {
-            SysAudio::playSound(objToString(args[0]));
-        }
-        return Obj(0);
-    };
-    nativeRegistry["audio.spectrum"] = [](const std::vector<Obj>& args) -> Obj {
-    if (args.empty()) return Obj(0.0);
-    int band = 0;
-    if (std::holds_alternative<int>(args[0].as)) band = std::get<int>(args[0].as);
-    else if (std::holds_alternative<double>(args[0].as)) band = (int)std::get<double>(args[0].as);
-    return Obj((double)SysAudio::getSpectrum(band)); 
-    };
+    bind<&SysAudio::playSound>("audio.play_sound");
+    bind<&SysAudio::getSpectrum>("audio.spectrum");
 }
 
 bool Runtime::isTruthy(const Obj& o) {
-    if (std::holds_alternative<bool>(o.as)) return std::get<bool>(o.as);
-    if (std::holds_alternative<int>(o.as)) return std::get<int>(o.as) != 0;
-    if (std::holds_alternative<double>(o.as)) return std::get<double>(o.as) != 0.0;
-    if (std::holds_alternative<std::string>(o.as)) return !std::get<std::string>(o.as).empty();
-    return !std::holds_alternative<std::monostate>(o.as);
+    if (o.isBool()) return o.asBool();
+    if (o.isInt()) return o.asInt() != 0;
+    if (o.isDouble()) return o.asDouble() != 0.0;
+    if (o.isString()) return !o.asLinkString().empty();
+    return !o.isNil();
 }
 
-FuncDecl* Runtime::findMethod(LinkClass* klass, const std::string& name) {
-    if (klass->methods.count(name)) {
-        return dynamic_cast<FuncDecl*>(klass->methods[name]);
+FuncDecl* Runtime::findMethod(LinkClass* klass, Atom name) {
+    auto it = klass->methods.find(name);
+    if (it != klass->methods.end() && it->second->kind == StmtKind::Func) {
+        return static_cast<FuncDecl*>(it->second);
     }
     return nullptr;
 }
 
+// A class's method table is fixed once its declaration has run, so the
+// cache only has to be refilled when the site sees a different class.
+FuncDecl* Runtime::cachedMethod(MethodCache& cache, const std::shared_ptr<LinkClass>& klass, Atom name) {
+    if (cache.klass != klass) {
+        cache.klass = klass;
+        cache.method = findMethod(klass.get(), name);
+    }
+    return cache.method;
+}
+
+// Natives take priority over user functions. The registry is complete once
+// the constructor returns, so a call site is looked up at most once.
+NativeFn Runtime::linkNative(CallSite& site, const std::string& name) {
+    if (site.link == CallSite::Link::Unlinked) {
+        auto it = nativeRegistry.find(name);
+        site.native = (it != nativeRegistry.end()) ? it->second : nullptr;
+        site.link = site.native ? CallSite::Link::Native : CallSite::Link::User;
+    }
+    return site.native;
+}
+
+// User functions live in ordinary variables, so redefining one rebinds the
+// slot the call site points at and no separate invalidation is needed.
+Obj Runtime::lookupCallee(const CallSite& site, Atom name) {
+    if (site.depth >= 0) {
+        if (Obj* slot = currentEnv->slotAt(site.depth, site.slot)) return *slot;
+    }
+    return currentEnv->get(name);
+}
+
 void Runtime::printObj(const Obj& val) {
     std::cout << objToString(val);
 }
+Obj Runtime::binaryOp(char op, const Obj& left, const Obj& right) {
+    if (left.isInt() && right.isInt()) {
+        int l = left.asInt();
+        int r = right.asInt();
+        
+        switch (op) {
+            case '&': return Obj(l & r);
+            case '|': return Obj(l | r);
+            case '^': return Obj(l ^ r);
+            case 'L': return Obj(l << r); // Left Shift
+            case 'R': return Obj(l >> r); // Right Shift
+        }
+    }
+    
+    if (op == '&' || op == '|') {
+        bool l = isTruthy(left);
+        bool r = isTruthy(right);
+        if (op == '&') return Obj(l && r);
+        if (op == '|') return Obj(l || r);
+    }
+    
+    if (left.isString() && op == '+') {
+        std::string result(left.asLinkString().view());
+        appendToString(result, right);
+        return Obj(std::move(result));
+    }
+
+    if (left.isInt() && right.isInt()) {
+        int l = left.asInt(), r = right.asInt();
+        switch (op) {
+            case '+': return Obj(l + r); case '-': return Obj(l - r); case '!': return Obj(l != r); 
+            case '*': return Obj(l * r); case '/': return Obj((r != 0) ? l / r : 0);
+            case '<': return Obj(l < r); case '>': return Obj(l > r); case '=': return Obj(l == r);
+        }
+    } else if (left.isNumber() && right.isNumber()) {
+        double l = left.asNumber();
+        double r = right.asNumber();
+        switch (op) {
+            case '+': return Obj(l + r); case '-': return Obj(l - r); case '!': return Obj(l != r); 
+            case '*': return Obj(l * r); case '/': return Obj((r != 0.0) ? l / r : 0.0);
+            case '<': return Obj(l < r); case '>': return Obj(l > r); case '=': return Obj(l == r);
+        }
+    } else if (left.isString() && right.isString()) {
+        if (op == '=') return Obj(left.asLinkString().view() == right.asLinkString().view());
+        if (op == '!') return Obj(left.asLinkString().view() != right.asLinkString().view());
+    } else if (left.isBool() && right.isBool()) {
+        bool l = left.asBool();
+        bool r = right.asBool();
+        if (op == '=') return Obj(l == r);
+        if (op == '!') return Obj(l != r);
+    }
+
+    return Obj();
+}
+
+// Same result as binaryOp('-', 0, operand); 0.0 - d keeps -0.0 negating to +0.0.
+Obj Runtime::negate(const Obj& operand) {
+    if (operand.isInt()) return Obj(0 - operand.asInt());
+    if (operand.isDouble()) return Obj(0.0 - operand.asDouble());
+    return Obj();
+}
+
+// A converted function captures only the cells its body uses and runs
+// with the global frame as parent; see Resolver.
+std::shared_ptr<LinkFunction> Runtime::makeClosure(FuncDecl* fn) {
+    auto closure = Collector::instance().track(std::make_shared<LinkFunction>());
+    closure->declaration = fn;
+    if (fn->capturesEnv) {
+        closure->closure = currentEnv;
+        return closure;
+    }
+    closure->closure = globalEnv;
+    closure->upvalues.reserve(fn->captures.size());
+    for (auto& capture : fn->captures) {
+        closure->upvalues.push_back(currentEnv->capture(capture.depth, capture.slot));
+    }
+    return closure;
+}
+
+std::shared_ptr<Environment> Runtime::callFrame(const LinkFunction& fn) {
+    auto frame = Environment::make(fn.closure, fn.declaration->layout);
+    auto& captures = fn.declaration->captures;
+    for (size_t i = 0; i < fn.upvalues.size(); i++) frame->attach(captures[i].target, fn.upvalues[i]);
+    return frame;
+}
+
+// `set s = s + x`. When s still holds the buffer that was read as the left
+// operand and nothing else shares it, the tail is appended in place, so
+// building a string from n pieces is linear instead of quadratic.
+void Runtime::assignConcat(int depth, int slot, Atom name, Obj left, const Obj& right) {
+    Obj* target = depth >= 0 ? currentEnv->slotAt(depth, slot) : nullptr;
+    if (!target) target = currentEnv->find(name);
+    if (target && left.isString() && target->isString() &&
+        target->asLinkString().sameBuffer(left.asLinkString())) {
+        left = Obj(); // Drop our reference so the slot can own the buffer
+        LinkString& buffer = std::get<LinkString>(target->as);
+        bool appended = right.isString() ? buffer.tryAppend(right.asLinkString().view())
+                                         : buffer.tryAppend(objToString(right));
+        if (appended) return;
+        left = *target;
+    }
+    Obj val = binaryOp('+', left, right);
+    if (target) *target = std::move(val);
+    else currentEnv->assign(name, std::move(val));
+}
+
+Obj Runtime::indexGet(const Obj& object, const Obj& index) {
+    if (object.isList() && index.isInt()) {
+        const List& list = *object.asList();
+        int i = index.asInt();
+        if (i < 0) i += list.size(); 
+        if (i >= 0 && i < (int)list.size()) return list[i];
+    } else if (object.isDict() && index.isString()) {
+        const Dict& dict = *object.asDict();
+        auto it = dict.find(index.asString());
+        if (it != dict.end()) return it->second;
+    }
+    return Obj();
+}
+
+void Runtime::indexSet(const Obj& listObj, const Obj& indexObj, const Obj& val) {
+    if (listObj.isList() && indexObj.isInt()) {
+        List& list = *listObj.asList();
+        int idx = indexObj.asInt();
+        if (idx < 0) idx += list.size();
+        if (idx >= 0 && idx < (int)list.size()) list[idx] = val;
+        else std::cout << "Runtime Error: Index out of bounds\n";
+    }
+}
+
+Obj Runtime::getProperty(const Obj& obj, Atom name, FieldCache* cache) {
+    // 1. Check if it is an OOP instance
+    if (obj.isInstance()) {
+        const LinkInstance& instance = *obj.asInstance();
+        int slot;
+        if (cache && cache->shape == instance.shape) {
+            slot = cache->slot;
+        } else {
+            slot = instance.shape->lookup(name);
+            if (cache) *cache = FieldCache{instance.shape, nullptr, slot};
+        }
+        if (slot >= 0) return instance.fields[slot];
+    }
+    // 2. Check if it is a Dictionary
+    if (obj.isDict()) {
+        const Dict& dict = *obj.asDict();
+        auto it = dict.find(name);
+        if (it != dict.end()) return it->second;
+    }
+    return Obj();
+}
+
+bool Runtime::setProperty(const Obj& obj, Atom name, const Obj& val, FieldCache* cache) {
+    // 1. Check if it is an OOP instance
+    if (obj.isInstance()) {
+        LinkInstance& instance = *obj.asInstance();
+        FieldCache miss;
+        FieldCache& entry = cache ? *cache : miss;
+        if (entry.shape != instance.shape) {
+            int slot = instance.shape->lookup(name);
+            if (slot >= 0) {
+                entry = FieldCache{instance.shape, nullptr, slot};
+            } else {
+                const auto& next = instance.shape->withField(name);
+                entry = FieldCache{instance.shape, next, next->lookup(name)};
+            }
+        }
+        if (entry.next) {
+            instance.fields.push_back(val);
+            instance.shape = entry.next;
+        } else {
+            instance.fields[entry.slot] = val;
+        }
+        return true;
+    }
+    // 2. Check if it is a Dictionary
+    if (obj.isDict()) {
+        (*obj.asDict())[name] = val;
+        return true;
+    }
+    return false;
+}
+
 Obj Runtime::evaluateExpr(Expr* expr) {
     if (!expr) return Obj();
 
+    switch (expr->kind) {
     // =========================================================
-    // 1. LITERALS & VARIABLES (Tetap Sama)
+    // 1. LITERALS & VARIABLES
     // =========================================================
-    if (auto num = dynamic_cast<NumberExpr*>(expr)) return Obj(num->value);
-    if (auto flt = dynamic_cast<FloatExpr*>(expr)) return Obj(flt->value);
-    if (auto str = dynamic_cast<StringExpr*>(expr)) return Obj(str->value);
-    if (auto chr = dynamic_cast<CharExpr*>(expr)) return Obj(chr->value);
-    if (auto bl = dynamic_cast<BoolExpr*>(expr)) return Obj(bl->value);
-    if (auto var = dynamic_cast<VariableExpr*>(expr)) return currentEnv->get(var->name);
+    case ExprKind::Number: return Obj(static_cast<NumberExpr*>(expr)->value);
+    case ExprKind::Float:  return Obj(static_cast<FloatExpr*>(expr)->value);
+    case ExprKind::String: return Obj(static_cast<StringExpr*>(expr)->value);
+    case ExprKind::Char:   return Obj(static_cast<CharExpr*>(expr)->value);
+    case ExprKind::Bool:   return Obj(static_cast<BoolExpr*>(expr)->value);
+    case ExprKind::Variable: {
+        auto var = static_cast<VariableExpr*>(expr);
+        if (var->depth >= 0) {
+            if (Obj* slot = currentEnv->slotAt(var->depth, var->slot)) return *slot;
+        }
+        return currentEnv->get(var->name);
+    }
 
     // =========================================================
-    // 2. DATA STRUCTURES (Tetap Sama)
+    // 2. DATA STRUCTURES
     // =========================================================
-    if (auto arr = dynamic_cast<ArrayExpr*>(expr)) {
-        auto list = std::make_shared<List>();
+    case ExprKind::Array: {
+        auto arr = static_cast<ArrayExpr*>(expr);
+        auto list = Collector::instance().track(std::make_shared<List>());
         for (auto& el : arr->elements) list->push_back(evaluateExpr(el.get()));
         return Obj(list);
     }
-    if (auto dictNode = dynamic_cast<DictExpr*>(expr)) {
-        auto dict = std::make_shared<Dict>();
+    case ExprKind::Dict: {
+        auto dictNode = static_cast<DictExpr*>(expr);
+        auto dict = Collector::instance().track(std::make_shared<Dict>());
         for (auto& p : dictNode->pairs) {
             Obj key = evaluateExpr(p.first.get());
             Obj val = evaluateExpr(p.second.get());
-            if (std::holds_alternative<std::string>(key.as)) (*dict)[std::get<std::string>(key.as)] = val;
+            if (key.isString()) (*dict)[key.asString()] = val;
             else std::cout << "Runtime Error: Dict key must be string.\n";
         }
         return Obj(dict);
     }
 
     // =========================================================
-    // 3. INDEX ACCESS (Tetap Sama)
+    // 3. INDEX ACCESS
     // =========================================================
-    if (auto idx = dynamic_cast<IndexExpr*>(expr)) {
+    case ExprKind::Index: {
+        auto idx = static_cast<IndexExpr*>(expr);
         Obj object = evaluateExpr(idx->object.get());
         Obj index = evaluateExpr(idx->index.get());
-        if (std::holds_alternative<std::shared_ptr<List>>(object.as) && std::holds_alternative<int>(index.as)) {
-            auto list = std::get<std::shared_ptr<List>>(object.as);
-            int i = std::get<int>(index.as);
-            if (i < 0) i += list->size(); 
-            if (i >= 0 && i < (int)list->size()) return (*list)[i];
-        } else if (std::holds_alternative<std::shared_ptr<Dict>>(object.as) && std::holds_alternative<std::string>(index.as)) {
-            auto dict = std::get<std::shared_ptr<Dict>>(object.as);
-            std::string key = std::get<std::string>(index.as);
-            if (dict->count(key)) return (*dict)[key];
-        }
-        return Obj();
+        return indexGet(object, index);
     }
 
     // =========================================================
-    // 4. OOP LOGIC (Copy paste your previous OOP logic here)
+    // 4. OOP LOGIC
     // =========================================================
-    if (auto newExpr = dynamic_cast<NewExpr*>(expr)) {
+    case ExprKind::New: {
+        auto newExpr = static_cast<NewExpr*>(expr);
         Obj classObj = currentEnv->get(newExpr->className);
         if (!std::holds_alternative<std::shared_ptr<LinkClass>>(classObj.as)) return Obj();
 
         auto klass = std::get<std::shared_ptr<LinkClass>>(classObj.as);
-        auto instance = std::make_shared<LinkInstance>();
-        instance->klass = klass;
+        auto instance = Collector::instance().track(std::make_shared<LinkInstance>(klass));
 
-        FuncDecl* init = findMethod(klass.get(), "init");
+        FuncDecl* init = cachedMethod(newExpr->initCache, klass, atoms::init);
         if (init) {
-            std::vector<Obj> args;
-            for (auto& arg : newExpr->args) args.push_back(evaluateExpr(arg.get()));
+            ArgFrame frame(*this, newExpr->args);
+            ArgSpan args = frame.span();
 
             auto prevEnv = currentEnv;
-            currentEnv = std::make_shared<Environment>(globalEnv);
-            currentEnv->define("this", Obj(instance));
+            currentEnv = Environment::make(globalEnv, init->layout);
+            currentEnv->define(atoms::self, Obj(instance));
             for (size_t i = 0; i < init->params.size(); ++i) {
                  if (i < args.size()) currentEnv->define(init->params[i], args[i]);
             }
-            try {
-                for (auto& s : init->body) runStatement(s.get());
-            } catch (const ReturnException&) {}
+            runBlock(init->body);
             currentEnv = prevEnv;
         }
         return Obj(instance);
     }
     
-    if (dynamic_cast<ThisExpr*>(expr)) return currentEnv->get("this");
-    
-    if (auto get = dynamic_cast<GetExpr*>(expr)) {
-        Obj obj = evaluateExpr(get->object.get());
-        // 1. Check if it is an OOP instance
-        if (std::holds_alternative<std::shared_ptr<LinkInstance>>(obj.as)) {
-            auto instance = std::get<std::shared_ptr<LinkInstance>>(obj.as);
-            if (instance->fields.count(get->name)) return instance->fields[get->name];
+    case ExprKind::This: {
+        auto self = static_cast<ThisExpr*>(expr);
+        if (self->depth >= 0) {
+            if (Obj* slot = currentEnv->slotAt(self->depth, self->slot)) return *slot;
         }
-        // 2. Check if it is a Dictionary (NEW FEATURE)
-        if (std::holds_alternative<std::shared_ptr<Dict>>(obj.as)) {
-            auto dict = std::get<std::shared_ptr<Dict>>(obj.as);
-            if (dict->count(get->name)) return (*dict)[get->name];
-        }
-        return Obj();
+        return currentEnv->get(atoms::self);
+    }
+    
+    case ExprKind::Get: {
+        auto get = static_cast<GetExpr*>(expr);
+        return getProperty(evaluateExpr(get->object.get()), get->name, &get->cache);
     }
     
-    if (auto set = dynamic_cast<SetExpr*>(expr)) {
+    case ExprKind::Set: {
+        auto set = static_cast<SetExpr*>(expr);
         Obj obj = evaluateExpr(set->object.get());
-        // 1. Check if it is an OOP instance
-        if (std::holds_alternative<std::shared_ptr<LinkInstance>>(obj.as)) {
-             auto instance = std::get<std::shared_ptr<LinkInstance>>(obj.as);
-             Obj val = evaluateExpr(set->value.get());
-             instance->fields[set->name] = val;
-             return val;
-        }
-        // 2. Check if it is a Dictionary (NEW FEATURE)
-        if (std::holds_alternative<std::shared_ptr<Dict>>(obj.as)) {
-             auto dict = std::get<std::shared_ptr<Dict>>(obj.as);
-             Obj val = evaluateExpr(set->value.get());
-             (*dict)[set->name] = val;
-             return val;
-        }
-        return Obj();
+        if (!std::holds_alternative<std::shared_ptr<LinkInstance>>(obj.as) &&
+            !std::holds_alternative<std::shared_ptr<Dict>>(obj.as)) return Obj();
+        Obj val = evaluateExpr(set->value.get());
+        setProperty(obj, set->name, val, &set->cache);
+        return val;
     }
 
-    if (auto methodCall = dynamic_cast<MethodCallExpr*>(expr)) {
+    case ExprKind::MethodCall: {
+         auto methodCall = static_cast<MethodCallExpr*>(expr);
          Obj obj = evaluateExpr(methodCall->object.get());
          if (!std::holds_alternative<std::shared_ptr<LinkInstance>>(obj.as)) return Obj();
          auto instance = std::get<std::shared_ptr<LinkInstance>>(obj.as);
-         FuncDecl* method = findMethod(instance->klass.get(), methodCall->method);
+         FuncDecl* method = cachedMethod(methodCall->cache, instance->klass, methodCall->method);
          if (!method) return Obj();
 
-         std::vector<Obj> args;
-         for (auto& arg : methodCall->args) args.push_back(evaluateExpr(arg.get()));
+         ArgFrame frame(*this, methodCall->args);
+         ArgSpan args = frame.span();
          
          auto prevEnv = currentEnv;
-         currentEnv = std::make_shared<Environment>(globalEnv);
-         currentEnv->define("this", Obj(instance));
+         currentEnv = Environment::make(globalEnv, method->layout);
+         currentEnv->define(atoms::self, Obj(instance));
          for (size_t i = 0; i < method->params.size(); ++i) {
              if (i < args.size()) currentEnv->define(method->params[i], args[i]);
          }
-         try { for (auto& s : method->body) runStatement(s.get()); } 
-         catch (const ReturnException& e) { currentEnv = prevEnv; return e.value; }
+         Completion result = runBlock(method->body);
          currentEnv = prevEnv;
+         if (result.type == Completion::Return) return result.value;
          return Obj();
     }
 
     // =========================================================
-    // 5. FUNCTION CALLS (THIS SECTION HAS COMPLETELY CHANGED!)
+    // 5. FUNCTION CALLS
     // =========================================================
-    if (auto call = dynamic_cast<CallExpr*>(expr)) {
-        std::vector<Obj> args;
-        for (auto& arg : call->args) {
-            args.push_back(evaluateExpr(arg.get()));
-        }
+    case ExprKind::Call: {
+        auto call = static_cast<CallExpr*>(expr);
+        ArgFrame frame(*this, call->args);
+        ArgSpan args = frame.span();
         
         // 1. Check Native Registry (print, os.exec, dll)
-        if (nativeRegistry.find(call->func) != nativeRegistry.end()) {
-            return nativeRegistry[call->func](args);
+        if (NativeFn native = linkNative(call->site, call->func)) {
+            return native(*this, args);
         }
         
         // 2. Execute from environment variable (user-defined function)
-        Obj callee = currentEnv->get(call->func);
+        Obj callee = lookupCallee(call->site, call->func);
         if (std::holds_alternative<std::shared_ptr<LinkFunction>>(callee.as)) {
             auto funcObj = std::get<std::shared_ptr<LinkFunction>>(callee.as);
             FuncDecl* fn = funcObj->declaration;
@@ -1010,20 +1058,15 @@ Obj Runtime::evaluateExpr(Expr* expr) {
 
             auto previousEnv = currentEnv;
             // New environment attaches to this function's closure
-            currentEnv = std::make_shared<Environment>(funcObj->closure);
+            currentEnv = callFrame(*funcObj);
             
             for (size_t i = 0; i < fn->params.size(); ++i) {
                 currentEnv->define(fn->params[i], args[i]);
             }
 
-            try {
-                for (auto& s : fn->body) runStatement(s.get());
-            } catch (const ReturnException& e) {
-                currentEnv = previousEnv; 
-                return e.value; // Return the value
-            }
-
+            Completion result = runBlock(fn->body);
             currentEnv = previousEnv;
+            if (result.type == Completion::Return) return result.value; // Return the value
             return Obj();
         }
         
@@ -1032,269 +1075,239 @@ Obj Runtime::evaluateExpr(Expr* expr) {
     }
 
     // =========================================================
-    // 6. BINARY OPERATIONS (Same as before, copy old logic)
+    // 6. BINARY OPERATIONS
     // =========================================================
-            if (auto bin = dynamic_cast<BinaryExpr*>(expr)) {
-            Obj left = evaluateExpr(bin->lhs.get());   
-            Obj right = evaluateExpr(bin->rhs.get());  
-            
-            if (std::holds_alternative<int>(left.as) && std::holds_alternative<int>(right.as)) {
-                int l = std::get<int>(left.as);
-                int r = std::get<int>(right.as);
-                
-                switch (bin->op) {
-                    case '&': return Obj(l & r);
-                    case '|': return Obj(l | r);
-                    case '^': return Obj(l ^ r);
-                    case 'L': return Obj(l << r); // Left Shift
-                    case 'R': return Obj(l >> r); // Right Shift
-                }
-            }
-            
-            if (bin->op == '&' || bin->op == '|') {
-            bool l = isTruthy(left);
-            bool r = isTruthy(right);
-            if (bin->op == '&') return Obj(l && r);
-            if (bin->op == '|') return Obj(l || r);
-        }
-            
-            if (std::holds_alternative<std::string>(left.as)) {
-                std::string sLeft = std::get<std::string>(left.as);
-                std::string sRight = objToString(right); 
-                
-                if (bin->op == '+') return Obj(sLeft + sRight);
-            }
-
-            if (std::holds_alternative<int>(left.as) && std::holds_alternative<int>(right.as)) {
-                int l = std::get<int>(left.as), r = std::get<int>(right.as);
-                switch (bin->op) {
-                    case '+': return Obj(l + r); case '-': return Obj(l - r); case '!': return Obj(l != r); 
-                    case '*': return Obj(l * r); case '/': return Obj((r != 0) ? l / r : 0);
-                    case '<': return Obj(l < r); case '>': return Obj(l > r); case '=': return Obj(l == r);
-                }
-            } else if ((std::holds_alternative<double>(left.as)||std::holds_alternative<int>(left.as)) && (std::holds_alternative<double>(right.as)||std::holds_alternative<int>(right.as))) {
-                double l = std::holds_alternative<int>(left.as)?std::get<int>(left.as):std::get<double>(left.as);
-                double r = std::holds_alternative<int>(right.as)?std::get<int>(right.as):std::get<double>(right.as);
-                switch (bin->op) {
-                    case '+': return Obj(l + r); case '-': return Obj(l - r); case '!': return Obj(l != r); 
-                    case '*': return Obj(l * r); case '/': return Obj((r != 0.0) ? l / r : 0.0);
-                    case '<': return Obj(l < r); case '>': return Obj(l > r); case '=': return Obj(l == r);
-                }
-            } else if (std::holds_alternative<std::string>(left.as) && std::holds_alternative<std::string>(right.as)) {
-                if (bin->op == '=') return Obj(std::get<std::string>(left.as) == std::get<std::string>(right.as));
-                if (bin->op == '!') return Obj(std::get<std::string>(left.as) != std::get<std::string>(right.as));
-            } else if (std::holds_alternative<bool>(left.as) && std::holds_alternative<bool>(right.as)) {
-                bool l = std::get<bool>(left.as);
-                bool r = std::get<bool>(right.as);
-                if (bin->op == '=') return Obj(l == r);
-                if (bin->op == '!') return Obj(l != r);
-            }
-        }
+    case ExprKind::Binary: {
+        auto bin = static_cast<BinaryExpr*>(expr);
+        Obj left = evaluateExpr(bin->lhs.get());   
+        Obj right = evaluateExpr(bin->rhs.get());  
+        return binaryOp(bin->op, left, right);
+    }
+    case ExprKind::Negate:
+        return negate(evaluateExpr(static_cast<NegateExpr*>(expr)->operand.get()));
+    }
 
     return Obj();
 }
 
+// Runs statements until one completes abruptly (return/break/continue)
+// and hands that completion back to the enclosing loop or call.
+Completion Runtime::runBlock(const std::vector<Node<Stmt>>& stmts) {
+    for (auto& s : stmts) {
+        Completion result = runStatement(s.get());
+        if (result.type != Completion::Normal) return result;
+    }
+    return {};
+}
+
 // --- 4. RUN STATEMENT ---
-void Runtime::runStatement(Stmt* stmt) {
-    if (!stmt) return;
+Completion Runtime::runStatement(Stmt* stmt) {
+    if (!stmt) return {};
 
+    switch (stmt->kind) {
     // 1. EXPRESSION & VARIABLE
-    if (auto exprStmt = dynamic_cast<ExprStmt*>(stmt)) {
+    case StmtKind::Expr: {
+        auto exprStmt = static_cast<ExprStmt*>(stmt);
         evaluateExpr(exprStmt->expression.get());
-        return;
+        return {};
     }
-    if (auto set = dynamic_cast<SetStmt*>(stmt)) {
-        currentEnv->assign(set->name, evaluateExpr(set->expression.get()));
-        return;
+    case StmtKind::Set: {
+        auto set = static_cast<SetStmt*>(stmt);
+        if (set->append) {
+            Obj left = evaluateExpr(set->append->lhs.get());
+            Obj right = evaluateExpr(set->append->rhs.get());
+            assignConcat(set->depth, set->slot, set->name, std::move(left), right);
+            return {};
+        }
+        Obj val = evaluateExpr(set->expression.get());
+        if (set->depth >= 0) {
+            if (Obj* slot = currentEnv->slotAt(set->depth, set->slot)) {
+                *slot = std::move(val);
+                return {};
+            }
+        }
+        currentEnv->assign(set->name, std::move(val));
+        return {};
     }
     
     // 2. ARRAY INDEX SET (list[0] = 1)
-    if (auto setIdx = dynamic_cast<SetIndexStmt*>(stmt)) {
+    case StmtKind::SetIndex: {
+        auto setIdx = static_cast<SetIndexStmt*>(stmt);
         Obj listObj = evaluateExpr(setIdx->list.get());
         Obj indexObj = evaluateExpr(setIdx->index.get());
         Obj val = evaluateExpr(setIdx->value.get());
-
-        if (std::holds_alternative<std::shared_ptr<List>>(listObj.as) && 
-            std::holds_alternative<int>(indexObj.as)) {
-            auto list = std::get<std::shared_ptr<List>>(listObj.as);
-            int idx = std::get<int>(indexObj.as);
-            if (idx < 0) idx += list->size();
-            if (idx >= 0 && idx < (int)list->size()) (*list)[idx] = val;
-            else std::cout << "Runtime Error: Index out of bounds\n";
-        }
-        return;
+        indexSet(listObj, indexObj, val);
+        return {};
     }
 
     // 3. CALL STATEMENT 
-    if (auto call = dynamic_cast<CallStmt*>(stmt)) {
-        std::vector<Obj> args;
-        for (auto& arg : call->args) args.push_back(evaluateExpr(arg.get()));
-
-        if (nativeRegistry.count(call->func)) {
-            nativeRegistry[call->func](args);
-            return;
+    case StmtKind::Call: {
+        auto call = static_cast<CallStmt*>(stmt);
+        ArgFrame frame(*this, call->args);
+        ArgSpan args = frame.span();
+
+        if (NativeFn native = linkNative(call->site, call->func)) {
+            native(*this, args);
+            return {};
         }
 
         // Fetch function from environment variable
-        Obj callee = currentEnv->get(call->func);
+        Obj callee = lookupCallee(call->site, call->func);
         if (std::holds_alternative<std::shared_ptr<LinkFunction>>(callee.as)) {
             auto funcObj = std::get<std::shared_ptr<LinkFunction>>(callee.as);
             FuncDecl* fn = funcObj->declaration;
             
             if (args.size() != fn->params.size()) {
-                std::cout << "Runtime Error: Arg mismatch.\n"; return;
+                std::cout << "Runtime Error: Arg mismatch.\n"; return {};
             }
             
             auto prevEnv = currentEnv;
             // New environment is parented to the function closure
-            currentEnv = std::make_shared<Environment>(funcObj->closure); 
+            currentEnv = callFrame(*funcObj); 
             
             for (size_t i = 0; i < fn->params.size(); ++i) {
                 currentEnv->define(fn->params[i], args[i]);
             }
-            try { 
-                for (auto& s : fn->body) runStatement(s.get()); 
-            } catch (const ReturnException&) {}
-            
+            runBlock(fn->body);
             currentEnv = prevEnv;
-            return;
+            return {};
         }
         std::cout << "Runtime Error: Unknown function '" << call->func << "'\n";
-        return;
+        return {};
     }
 
     // 4. CONTROL FLOW (If, While, For, Try-Catch)
-    if (auto ifStmt = dynamic_cast<IfStmt*>(stmt)) {
-            if (isTruthy(evaluateExpr(ifStmt->condition.get()))) {
-                for (auto& s : ifStmt->thenBranch) runStatement(s.get());
-            } else {
-                for (auto& s : ifStmt->elseBranch) runStatement(s.get());
-            }
-            return;
-        }
-    if (auto whileLoop = dynamic_cast<WhileStmt*>(stmt)) {
-            while (isTruthy(evaluateExpr(whileLoop->condition.get()))) {
-                try {
-                    for (auto& s : whileLoop->body) runStatement(s.get());
-                } 
-                catch (const BreakException&) {
-                    break; // Stop while loop C++
-                }
-                catch (const ContinueException&) {
-                    continue; 
-                }
-            }
-            return;
+    case StmtKind::If: {
+        auto ifStmt = static_cast<IfStmt*>(stmt);
+        if (isTruthy(evaluateExpr(ifStmt->condition.get()))) {
+            return runBlock(ifStmt->thenBranch);
         }
-    if (auto loop = dynamic_cast<ForStmt*>(stmt)) {
-             Obj collection = evaluateExpr(loop->collection.get());
-             if (std::holds_alternative<std::shared_ptr<List>>(collection.as)) {
-                 auto list = std::get<std::shared_ptr<List>>(collection.as);
-                 currentEnv->define(loop->iteratorName, Obj(0)); 
-
-                 for (auto& item : *list) {
-                     currentEnv->assign(loop->iteratorName, item);
-                     try {
-                         for (auto& s : loop->body) runStatement(s.get());
-                     }
-                     catch (const BreakException&) {
-                         break; 
-                     }
-                     catch (const ContinueException&) {
-                         continue; 
-                     }
-                 }
-             }
-             return;
+        return runBlock(ifStmt->elseBranch);
+    }
+    case StmtKind::While: {
+        auto whileLoop = static_cast<WhileStmt*>(stmt);
+        while (isTruthy(evaluateExpr(whileLoop->condition.get()))) {
+            Completion result = runBlock(whileLoop->body);
+            if (result.type == Completion::Break) break;
+            if (result.type == Completion::Return) return result;
         }
-    if (auto tryStmt = dynamic_cast<TryStmt*>(stmt)) {
-            try {
-                for (auto& s : tryStmt->tryBody) runStatement(s.get());
-            } catch (const RuntimeException& e) {
-                auto prevEnv = currentEnv;
-                currentEnv = std::make_shared<Environment>(prevEnv);
-                currentEnv->define(tryStmt->errorVar, Obj(e.message));
-                for (auto& s : tryStmt->catchBody) runStatement(s.get());
-                currentEnv = prevEnv;
+        return {};
+    }
+    case StmtKind::For: {
+        auto loop = static_cast<ForStmt*>(stmt);
+        Obj collection = evaluateExpr(loop->collection.get());
+        if (std::holds_alternative<std::shared_ptr<List>>(collection.as)) {
+            auto list = std::get<std::shared_ptr<List>>(collection.as);
+            currentEnv->define(loop->iteratorName, Obj(0)); 
+
+            for (auto& item : *list) {
+                if (loop->slot >= 0) currentEnv->bind(loop->slot, item);
+                else currentEnv->assign(loop->iteratorName, item);
+                Completion result = runBlock(loop->body);
+                if (result.type == Completion::Break) break;
+                if (result.type == Completion::Return) return result;
             }
-            return;
-        }
-    if (auto ret = dynamic_cast<ReturnStmt*>(stmt)) {
-			Obj result; 
-			if (ret->value) result = evaluateExpr(ret->value.get()); 
-			throw ReturnException(result); 
-		}
-	if (dynamic_cast<BreakStmt*>(stmt)) {
-            throw BreakException(); 
         }
-    if (dynamic_cast<ContinueStmt*>(stmt)) {
-            throw ContinueException(); 
+        return {};
+    }
+    case StmtKind::Try: {
+        auto tryStmt = static_cast<TryStmt*>(stmt);
+        try {
+            return runBlock(tryStmt->tryBody);
+        } catch (const RuntimeException& e) {
+            auto prevEnv = currentEnv;
+            currentEnv = Environment::make(prevEnv, tryStmt->catchLayout);
+            currentEnv->define(tryStmt->errorVar, Obj(e.message));
+            Completion result = runBlock(tryStmt->catchBody);
+            currentEnv = prevEnv;
+            return result;
         }
+    }
+    case StmtKind::Return: {
+        auto ret = static_cast<ReturnStmt*>(stmt);
+        Obj result; 
+        if (ret->value) result = evaluateExpr(ret->value.get()); 
+        return {Completion::Return, std::move(result)};
+    }
+    case StmtKind::Break:
+        return {Completion::Break};
+    case StmtKind::Continue:
+        return {Completion::Continue};
 
     // 5. DEFINITIONS
-    if (auto func = dynamic_cast<FuncDecl*>(stmt)) {
-        auto linkFunc = std::make_shared<LinkFunction>();
-        linkFunc->declaration = func;
-        linkFunc->closure = currentEnv; 
-        currentEnv->define(func->name, Obj(linkFunc)); 
-        return;
+    case StmtKind::Func: {
+        auto func = static_cast<FuncDecl*>(stmt);
+        currentEnv->define(func->name, Obj(makeClosure(func))); 
+        return {};
     }
-    if (auto cls = dynamic_cast<ClassDecl*>(stmt)) {
+    case StmtKind::Class: {
+        auto cls = static_cast<ClassDecl*>(stmt);
         auto klass = std::make_shared<LinkClass>();
         klass->name = cls->name;
         for (auto& method : cls->methods) klass->methods[method->name] = method.get();
         currentEnv->define(cls->name, Obj(klass));
-        return;
+        return {};
     }
-    if (dynamic_cast<ClearStmt*>(stmt)) {
+    case StmtKind::Clear: {
+        OutputBuffer::instance().flush();
         #ifdef _WIN32 
         system("cls"); 
         #else 
         system("clear"); 
         #endif
-        return; 
+        return {}; 
     }
-    if (auto prop = dynamic_cast<PropertyStmt*>(stmt)) { 
-        if (prop->name == "sh") { int s = system(prop->value.c_str()); (void)s; }
-        return;
+    case StmtKind::Property: {
+        auto prop = static_cast<PropertyStmt*>(stmt); 
+        if (prop->name == "sh") {
+            OutputBuffer::instance().flush();
+            int s = system(prop->value.c_str()); (void)s;
+        }
+        return {};
     }
-    if (auto imp = dynamic_cast<ImportStmt*>(stmt)) {
+    case StmtKind::Import: {
+        auto imp = static_cast<ImportStmt*>(stmt);
 		 std::string path = imp->path;
          if (!Sys::fileExists(path)) {
              std::cout << "Runtime Error: Cannot import '" << path << "'. File not found.\n";
-             return;
+             return {};
          }
          std::string source = Sys::readFile(path);
          Lexer lexer(source);
-         auto tokens = lexer.tokenize();
-         Parser parser(tokens);
+         Parser parser(lexer);
          auto importedProgram = parser.parse();
          
          if (importedProgram) {
+             Optimizer(*this).optimize(*importedProgram);
+             // Inside a function the importing frame is dynamic, so only
+             // top-level imports get lexical addresses
+             if (currentEnv == globalEnv) Resolver(globalEnv->layout).resolve(*importedProgram);
              loadedPrograms.push_back(std::move(importedProgram));
              Program* storedProgram = loadedPrograms.back().get();
-             for (auto& s : storedProgram->statements) {
-                 runStatement(s.get());
-             }
+             return runBlock(storedProgram->statements);
          }
-         return;
+         return {};
     }
-    if (auto ext = dynamic_cast<ExternStmt*>(stmt)) {
+    case StmtKind::Extern: {
+        auto ext = static_cast<ExternStmt*>(stmt);
         #ifdef _WIN32
         std::cout << "Runtime Error: Extern blocks require POSIX environments.\n";
-        return;
+        return {};
         #else
         
         // --- 1. DETECT ALL ACTIVE VARIABLES IN LINK-LANG ---
-        std::vector<std::string> int_vars;
-        std::vector<std::string> double_vars;
+        std::vector<Atom> int_vars;
+        std::vector<Atom> double_vars;
         
         // Collect from current scope up to global
         Environment* env_ptr = currentEnv.get();
-        std::unordered_map<std::string, Obj> all_vars;
+        std::unordered_map<Atom, Obj> all_vars;
         while (env_ptr) {
-            for (const auto& [name, val] : env_ptr->values) {
-                if (all_vars.find(name) == all_vars.end()) all_vars[name] = val;
+            for (size_t i = 0; i < env_ptr->slots.size(); ++i) {
+                Cell& cell = Environment::storage(env_ptr->slots[i]);
+                if (!cell.bound) continue;
+                Atom name = env_ptr->layout->names[i];
+                if (all_vars.find(name) == all_vars.end()) all_vars[name] = cell.value;
             }
             env_ptr = env_ptr->enclosing.get();
         }
@@ -1347,7 +1360,7 @@ void Runtime::runStatement(Stmt* stmt) {
             std::string cmd = "g++ -shared -fPIC -o " + soPath + " " + cppPath + " " + ext->flags;
             
             if (system(cmd.c_str()) != 0) {
-                std::cout << "Runtime Error: Gagal mengkompilasi C++ native.\n"; return;
+                std::cout << "Runtime Error: Gagal mengkompilasi C++ native.\n"; return {};
             }
         }
 
@@ -1368,6 +1381,7 @@ void Runtime::runStatement(Stmt* stmt) {
             shm_doubles[i] = std::get<double>(all_vars[double_vars[i]].as);
 
         // --- 6. EXECUTE C++ (FORK) ---
+        OutputBuffer::instance().flush(); // Or the child would print it again on exit
         pid_t pid = fork();
         if (pid == 0) {
             void* handle = dlopen(soPath.c_str(), RTLD_NOW);
@@ -1391,13 +1405,16 @@ void Runtime::runStatement(Stmt* stmt) {
             munmap(shared_mem, 4096); shm_unlink(shm_name);
         }
         #endif
-        return;
+        return {};
+    }
+    default:
+        return {};
     }
 }
 
 void Runtime::execute(std::unique_ptr<Program> program) {
     if (!program) return;
-    for (auto& stmt : program->statements) {
-        runStatement(stmt.get());
-    }
+    Resolver(globalEnv->layout).resolve(*program);
+    // A stray top-level return/break/continue simply ends the script
+    runBlock(program->statements);
 }
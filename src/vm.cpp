@@ -0,0 +1,362 @@
+#include "vm.h"
+#include "gc.h"
+#include <iostream>
+
+void VM::execute(std::unique_ptr<Program> program, bool debugMode) {
+    if (!program) return;
+    debug = debugMode;
+
+    Resolver(rt.globalEnv->layout).resolve(*program);
+    auto chunk = compiler.compileProgram(*program);
+    if (debug) disassembleChunk(*chunk, "<script>");
+
+    // Function objects point into the AST, so it has to outlive this run
+    rt.loadedPrograms.push_back(std::move(program));
+
+    auto entryEnv = rt.currentEnv;
+    frames.push_back(CallFrame{chunk.get(), 0, stack.size(), entryEnv, nullptr, true});
+    try {
+        run();
+    } catch (...) {
+        frames.clear();
+        stack.clear();
+        rt.currentEnv = entryEnv;
+        throw;
+    }
+}
+
+Chunk* VM::chunkFor(FuncDecl* fn) {
+    auto it = functionChunks.find(fn);
+    if (it != functionChunks.end()) return it->second.get();
+
+    auto chunk = compiler.compileFunction(*fn);
+    if (debug) disassembleChunk(*chunk, fn->name);
+    Chunk* result = chunk.get();
+    functionChunks[fn] = std::move(chunk);
+    return result;
+}
+
+void VM::callFunction(FuncDecl* fn, std::shared_ptr<Environment> env, size_t argc,
+                      bool discardResult, std::shared_ptr<LinkInstance> constructed) {
+    size_t first = stack.size() - argc;
+    for (size_t i = 0; i < fn->params.size() && i < argc; ++i) {
+        env->define(fn->params[i], stack[first + i]);
+    }
+    stack.resize(first);
+
+    frames.push_back(CallFrame{chunkFor(fn), 0, stack.size(), rt.currentEnv, std::move(constructed), discardResult});
+    rt.currentEnv = std::move(env);
+}
+
+// Pops the current frame. Returns false once the script frame has finished.
+bool VM::finishFrame(Obj result) {
+    CallFrame frame = std::move(frames.back());
+    frames.pop_back();
+    stack.resize(frame.base);
+    rt.currentEnv = frame.callerEnv;
+
+    if (frames.empty()) return false;
+    if (frame.constructed) stack.push_back(Obj(frame.constructed));
+    else if (!frame.discardResult) stack.push_back(std::move(result));
+    return true;
+}
+
+void VM::run() {
+    Chunk* chunk = frames.back().chunk;
+    size_t ip = frames.back().ip;
+
+#define READ_BYTE() (chunk->code[ip++])
+#define READ_SHORT() (ip += 2, (uint16_t)((chunk->code[ip - 2] << 8) | chunk->code[ip - 1]))
+#define SYNC_FRAME() do { chunk = frames.back().chunk; ip = frames.back().ip; } while (0)
+
+    while (true) {
+        OpCode op = static_cast<OpCode>(READ_BYTE());
+        switch (op) {
+        case OpCode::CONSTANT:
+            stack.push_back(chunk->constants[READ_SHORT()]);
+            break;
+        case OpCode::NIL:   stack.push_back(Obj()); break;
+        case OpCode::TRUE:  stack.push_back(Obj(true)); break;
+        case OpCode::FALSE: stack.push_back(Obj(false)); break;
+        case OpCode::POP:   stack.pop_back(); break;
+
+        case OpCode::GET_VAR:
+            stack.push_back(rt.currentEnv->get(chunk->names[READ_SHORT()]));
+            break;
+        case OpCode::SET_VAR: {
+            Atom name = chunk->names[READ_SHORT()];
+            rt.currentEnv->assign(name, std::move(stack.back()));
+            stack.pop_back();
+            break;
+        }
+        case OpCode::GET_SLOT: {
+            uint8_t depth = READ_BYTE();
+            uint16_t slot = READ_SHORT();
+            uint16_t name = READ_SHORT();
+            Obj* val = rt.currentEnv->slotAt(depth, slot);
+            stack.push_back(val ? *val : rt.currentEnv->get(chunk->names[name]));
+            break;
+        }
+        case OpCode::SET_SLOT: {
+            uint8_t depth = READ_BYTE();
+            uint16_t slot = READ_SHORT();
+            uint16_t name = READ_SHORT();
+            if (Obj* val = rt.currentEnv->slotAt(depth, slot)) *val = std::move(stack.back());
+            else rt.currentEnv->assign(chunk->names[name], std::move(stack.back()));
+            stack.pop_back();
+            break;
+        }
+        case OpCode::APPEND_SLOT: {
+            uint8_t depth = READ_BYTE();
+            uint16_t slot = READ_SHORT();
+            uint16_t name = READ_SHORT();
+            Obj right = std::move(stack.back());
+            stack.pop_back();
+            Obj left = std::move(stack.back());
+            stack.pop_back();
+            rt.assignConcat(depth, slot, chunk->names[name], std::move(left), right);
+            break;
+        }
+
+        case OpCode::BINARY: {
+            char binOp = (char)READ_BYTE();
+            Obj right = std::move(stack.back());
+            stack.pop_back();
+            stack.back() = rt.binaryOp(binOp, stack.back(), right);
+            break;
+        }
+
+        case OpCode::NEGATE:
+            stack.back() = rt.negate(stack.back());
+            break;
+
+        case OpCode::MAKE_LIST: {
+            uint16_t count = READ_SHORT();
+            auto list = Collector::instance().track(std::make_shared<List>(
+                std::make_move_iterator(stack.end() - count), std::make_move_iterator(stack.end())));
+            stack.resize(stack.size() - count);
+            stack.push_back(Obj(list));
+            break;
+        }
+        case OpCode::MAKE_DICT: {
+            uint16_t count = READ_SHORT();
+            auto dict = Collector::instance().track(std::make_shared<Dict>());
+            size_t first = stack.size() - count * 2;
+            for (size_t i = first; i < stack.size(); i += 2) {
+                const Obj& key = stack[i];
+                if (key.isString()) (*dict)[key.asString()] = stack[i + 1];
+                else std::cout << "Runtime Error: Dict key must be string.\n";
+            }
+            stack.resize(first);
+            stack.push_back(Obj(dict));
+            break;
+        }
+        case OpCode::GET_INDEX: {
+            Obj index = std::move(stack.back());
+            stack.pop_back();
+            stack.back() = rt.indexGet(stack.back(), index);
+            break;
+        }
+        case OpCode::SET_INDEX: {
+            size_t top = stack.size();
+            rt.indexSet(stack[top - 3], stack[top - 2], stack[top - 1]);
+            stack.resize(top - 3);
+            break;
+        }
+        case OpCode::GET_FIELD: {
+            Atom name = chunk->names[READ_SHORT()];
+            FieldCache* cache = chunk->fieldCaches[READ_SHORT()];
+            stack.back() = rt.getProperty(stack.back(), name, cache);
+            break;
+        }
+        case OpCode::SET_FIELD: {
+            Atom name = chunk->names[READ_SHORT()];
+            FieldCache* cache = chunk->fieldCaches[READ_SHORT()];
+            Obj val = std::move(stack.back());
+            stack.pop_back();
+            bool stored = rt.setProperty(stack.back(), name, val, cache);
+            stack.back() = stored ? std::move(val) : Obj();
+            break;
+        }
+
+        case OpCode::CALL:
+        case OpCode::CALL_STMT: {
+            Atom name = chunk->names[READ_SHORT()];
+            CallSite& site = *chunk->callSites[READ_SHORT()];
+            size_t argc = READ_BYTE();
+            bool isStmt = (op == OpCode::CALL_STMT);
+
+            // 1. Native registry first, same lookup order as the tree walker
+            if (NativeFn native = rt.linkNative(site, name)) {
+                // Arguments are passed in place on the operand stack
+                Obj result = native(rt, ArgSpan{stack.data() + stack.size() - argc, argc});
+                stack.resize(stack.size() - argc);
+                if (!isStmt) stack.push_back(std::move(result));
+                break;
+            }
+
+            // 2. User-defined function from the environment
+            Obj callee = rt.lookupCallee(site, name);
+            if (std::holds_alternative<std::shared_ptr<LinkFunction>>(callee.as)) {
+                auto funcObj = std::get<std::shared_ptr<LinkFunction>>(callee.as);
+                FuncDecl* fn = funcObj->declaration;
+                if (argc != fn->params.size()) {
+                    if (isStmt) std::cout << "Runtime Error: Arg mismatch.\n";
+                    else std::cout << "Runtime Error: Function " << fn->name << " arg mismatch.\n";
+                    stack.resize(stack.size() - argc);
+                    if (!isStmt) stack.push_back(Obj());
+                    break;
+                }
+                frames.back().ip = ip;
+                callFunction(fn, rt.callFrame(*funcObj), argc, isStmt);
+                SYNC_FRAME();
+                break;
+            }
+
+            std::cout << "Runtime Error: Unknown function '" << name << "'\n";
+            stack.resize(stack.size() - argc);
+            if (!isStmt) stack.push_back(Obj());
+            break;
+        }
+
+        case OpCode::INVOKE: {
+            Atom name = chunk->names[READ_SHORT()];
+            MethodCache& cache = *chunk->methodCaches[READ_SHORT()];
+            size_t argc = READ_BYTE();
+            Obj object = stack[stack.size() - argc - 1];
+
+            FuncDecl* method = nullptr;
+            if (std::holds_alternative<std::shared_ptr<LinkInstance>>(object.as)) {
+                method = rt.cachedMethod(cache, std::get<std::shared_ptr<LinkInstance>>(object.as)->klass, name);
+            }
+            if (!method) {
+                stack.resize(stack.size() - argc - 1);
+                stack.push_back(Obj());
+                break;
+            }
+
+            stack.erase(stack.end() - argc - 1);
+            auto env = Environment::make(rt.globalEnv, method->layout);
+            env->define(atoms::self, object);
+            frames.back().ip = ip;
+            callFunction(method, std::move(env), argc, false);
+            SYNC_FRAME();
+            break;
+        }
+
+        case OpCode::NEW: {
+            Atom name = chunk->names[READ_SHORT()];
+            MethodCache& cache = *chunk->methodCaches[READ_SHORT()];
+            size_t argc = READ_BYTE();
+            Obj classObj = rt.currentEnv->get(name);
+            if (!std::holds_alternative<std::shared_ptr<LinkClass>>(classObj.as)) {
+                stack.resize(stack.size() - argc);
+                stack.push_back(Obj());
+                break;
+            }
+
+            auto klass = std::get<std::shared_ptr<LinkClass>>(classObj.as);
+            auto instance = Collector::instance().track(std::make_shared<LinkInstance>(klass));
+
+            FuncDecl* init = rt.cachedMethod(cache, klass, atoms::init);
+            if (!init) {
+                stack.resize(stack.size() - argc);
+                stack.push_back(Obj(instance));
+                break;
+            }
+
+            auto env = Environment::make(rt.globalEnv, init->layout);
+            env->define(atoms::self, Obj(instance));
+            frames.back().ip = ip;
+            callFunction(init, std::move(env), argc, false, instance);
+            SYNC_FRAME();
+            break;
+        }
+
+        case OpCode::JUMP: {
+            uint16_t offset = READ_SHORT();
+            ip += offset;
+            break;
+        }
+        case OpCode::JUMP_IF_FALSE: {
+            uint16_t offset = READ_SHORT();
+            if (!rt.isTruthy(stack.back())) ip += offset;
+            stack.pop_back();
+            break;
+        }
+        case OpCode::LOOP: {
+            uint16_t offset = READ_SHORT();
+            ip -= offset;
+            break;
+        }
+
+        case OpCode::FOR_PREP: {
+            Atom name = chunk->names[READ_SHORT()];
+            uint16_t slot = READ_SHORT();
+            uint16_t offset = READ_SHORT();
+            if (!std::holds_alternative<std::shared_ptr<List>>(stack.back().as)) {
+                stack.pop_back();
+                ip += offset;
+                break;
+            }
+            stack.push_back(Obj(0));
+            if (slot != 0xffff) rt.currentEnv->bind(slot, Obj(0));
+            else rt.currentEnv->define(name, Obj(0));
+            break;
+        }
+        case OpCode::FOR_NEXT: {
+            Atom name = chunk->names[READ_SHORT()];
+            uint16_t slot = READ_SHORT();
+            uint16_t offset = READ_SHORT();
+            size_t top = stack.size();
+            auto& list = std::get<std::shared_ptr<List>>(stack[top - 2].as);
+            int i = std::get<int>(stack[top - 1].as);
+            if (i >= (int)list->size()) {
+                ip += offset;
+                break;
+            }
+            Obj* var = slot != 0xffff ? rt.currentEnv->slotAt(0, slot) : nullptr;
+            if (var) *var = (*list)[i];
+            else rt.currentEnv->assign(name, (*list)[i]);
+            stack[top - 1] = Obj(i + 1);
+            break;
+        }
+
+        case OpCode::CLOSURE: {
+            FuncDecl* func = chunk->functions[READ_SHORT()];
+            rt.currentEnv->define(func->name, Obj(rt.makeClosure(func)));
+            break;
+        }
+
+        case OpCode::EXEC_STMT: {
+            const FallbackStmt& fb = chunk->fallbacks[READ_SHORT()];
+            frames.back().ip = ip;
+            Completion result = rt.runStatement(fb.stmt);
+            if (result.type == Completion::Normal) break;
+
+            if (result.type == Completion::Break && fb.breakTarget >= 0) {
+                ip = (size_t)fb.breakTarget;
+            } else if (result.type == Completion::Continue && fb.continueTarget >= 0) {
+                ip = (size_t)fb.continueTarget;
+            } else {
+                // 'return', or break/continue with no loop around it, ends the frame
+                if (!finishFrame(result.type == Completion::Return ? std::move(result.value) : Obj())) return;
+                SYNC_FRAME();
+            }
+            break;
+        }
+
+        case OpCode::RETURN: {
+            Obj result = std::move(stack.back());
+            stack.pop_back();
+            if (!finishFrame(std::move(result))) return;
+            SYNC_FRAME();
+            break;
+        }
+        }
+    }
+
+#undef READ_BYTE
+#undef READ_SHORT
+#undef SYNC_FRAME
+}